@@ -0,0 +1,72 @@
+/*!
+	@file   bit_matrix.hpp
+	@author Gavin Lyons
+	@brief  Bit matrix helpers for LED modules, 8x8 bit matrices packed in a uint64_t.
+*/
+
+#ifndef BIT_MATRIX_H
+#define BIT_MATRIX_H
+
+#include <cstdint>
+
+/*!
+	@brief Bit matrix helpers
+	@details An 8x8 bit matrix is packed row by row into a uint64_t,
+		row r is byte r (bits 8r to 8r+7), column c is bit c of that byte.
+*/
+namespace BitMatrix
+{
+	/*!
+		@brief Transpose an 8x8 bit matrix, element (r,c) moves to (c,r)
+		@param x packed matrix
+		@return transposed matrix
+		@note Three swap-mask steps, swapping 1x1, 2x2 then 4x4 blocks across the diagonal.
+	*/
+	inline uint64_t transpose8x8(uint64_t x)
+	{
+		uint64_t t;
+		t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+		x = x ^ t ^ (t << 7);
+		t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+		x = x ^ t ^ (t << 14);
+		t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+		x = x ^ t ^ (t << 28);
+		return x;
+	}
+
+	/*!
+		@brief Swap the upper and lower nibble of every byte
+		@param x packed matrix
+		@return matrix with nibbles swapped
+	*/
+	inline uint64_t swapNibbles(uint64_t x)
+	{
+		return ((x & 0x0F0F0F0F0F0F0F0FULL) << 4) | ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL);
+	}
+
+	/*!
+		@brief Mirror an 8x8 bit matrix left to right, column c moves to column 7-c
+		@param x packed matrix
+		@return mirrored matrix
+		@note Reverses the bits of every byte, swapping nibbles, bit pairs then bits.
+	*/
+	inline uint64_t flipHorizontal(uint64_t x)
+	{
+		x = swapNibbles(x);
+		x = ((x & 0x3333333333333333ULL) << 2) | ((x >> 2) & 0x3333333333333333ULL);
+		x = ((x & 0x5555555555555555ULL) << 1) | ((x >> 1) & 0x5555555555555555ULL);
+		return x;
+	}
+
+	/*!
+		@brief Mirror an 8x8 bit matrix top to bottom, row r moves to row 7-r
+		@param x packed matrix
+		@return mirrored matrix
+	*/
+	inline uint64_t flipVertical(uint64_t x)
+	{
+		return __builtin_bswap64(x);
+	}
+}
+
+#endif
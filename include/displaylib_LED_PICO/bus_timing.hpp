@@ -0,0 +1,45 @@
+/*!
+	@file   bus_timing.hpp
+	@author Gavin Lyons
+	@brief  Sub-microsecond delay used by the bit-banged serial buses of the LED modules.
+*/
+
+#ifndef BUS_TIMING_H
+#define BUS_TIMING_H
+
+#include <cstdint>
+#include "pico/stdlib.h"
+
+/*!
+	@class BusTiming
+	@brief A delay set in nanoseconds and spun in CPU cycles.
+	@details The delay is converted to CPU cycles from the current clk_sys frequency,
+		wait() then spins for at least that many cycles. update() recomputes the
+		cycle count if the system clock has changed since the last call,
+		drivers call it once at the start of each bus transaction.
+*/
+class BusTiming
+{
+public:
+	BusTiming(uint32_t delayNs = 0);
+
+	void setDelayNs(uint32_t delayNs);
+	uint32_t getDelayNs(void) const;
+	uint32_t getDelayCycles(void) const;
+	void update(void);
+
+	/*! @brief Spin for the set delay, no-op when the delay is zero */
+	inline void wait(void) const
+	{
+		if (_cycles != 0) busy_wait_at_least_cycles(_cycles);
+	}
+
+private:
+	uint32_t _delayNs = 0; /**< Delay in nanoseconds */
+	uint32_t _cycles = 0;  /**< Delay in clk_sys cycles */
+	uint32_t _sysHz = 0;   /**< clk_sys frequency the cycle count was computed for */
+
+	void recompute(uint32_t sysHz);
+};
+
+#endif
@@ -0,0 +1,98 @@
+/*!
+	@file   key_scanner.hpp
+	@author Gavin Lyons
+	@brief  Background key scanner with debounce and event queue, for LED modules with a key matrix.
+*/
+
+#ifndef KEY_SCANNER_H
+#define KEY_SCANNER_H
+
+#include <cstdint>
+#include "pico/stdlib.h"
+
+/*!
+	@class KeyScanner
+	@brief Samples a key matrix of up to 16 keys at a fixed rate, debounces each key and
+		queues press, release and long press events.
+	@details Sampling is driven by a repeating_timer (scanBegin) or by calling scanTick()
+		from the application (polled mode). Sub-classes with a slow key read clear
+		_readInInterrupt, the timer then only marks a sample due and the application
+		takes it by calling poll() from its main loop. Each key has an integrating debounce counter,
+		a key changes state only after the counter has run all the way up or down.
+		Events go into a single producer single consumer ring buffer, the producer is the
+		scanner, the consumer is the application calling getEvent(), neither side blocks.
+		Sub-classes supply the raw key read for a particular chip.
+		Designed for a single core, scanner and application on the same core.
+*/
+class KeyScanner
+{
+public:
+	/*! Type of key event */
+	enum KeyEventType_e : uint8_t
+	{
+		KeyPress     = 0, /**< Key went down */
+		KeyRelease   = 1, /**< Key went up */
+		KeyLongPress = 2  /**< Key held down for the long press time, sent once per press */
+	};
+	/*! A key event */
+	struct KeyEvent_t
+	{
+		uint8_t key;         /**< Key number 0-15, bit number in the raw key mask */
+		KeyEventType_e type; /**< Type of event */
+	};
+
+	KeyScanner();
+	virtual ~KeyScanner();
+
+	bool scanBegin(uint32_t periodMs);
+	void scanEnd(void);
+	bool isScanning(void) const;
+	void scanTick(void);
+	void poll(void);
+
+	bool getEvent(KeyEvent_t &event);
+	uint8_t getEventCount(void) const;
+	uint16_t getKeyState(void) const;
+	uint16_t getOverflowCount(void) const;
+
+	void setDebounce(uint8_t samples);
+	void setLongPress(uint16_t samples);
+
+protected:
+	/*!
+		@brief Read the raw state of the key matrix
+		@param keys set to one bit per key, 1 = pressed
+		@return true sample taken, false bus busy and sample deferred
+	*/
+	virtual bool readKeys(uint16_t &keys) = 0;
+
+	bool _readInInterrupt = true; /**< true the timer reads the keys, false the timer only marks a sample due for poll() */
+
+	void sampleDue(void);
+
+	static constexpr uint8_t KEY_COUNT = 16;        /**< Maximum number of keys */
+	static constexpr uint8_t EVENT_QUEUE_SIZE = 16; /**< Event queue size, power of 2 */
+
+private:
+	KeyEvent_t _queue[EVENT_QUEUE_SIZE];  /**< Event ring buffer */
+	volatile uint8_t _head = 0;           /**< Next slot written by producer */
+	volatile uint8_t _tail = 0;           /**< Next slot read by consumer */
+	uint16_t _overflowCount = 0;          /**< Events dropped because the queue was full */
+
+	uint8_t _integrator[KEY_COUNT] = {0}; /**< Debounce counters */
+	uint16_t _heldSamples[KEY_COUNT] = {0}; /**< Samples each key has been held down */
+	uint16_t _keyState = 0;               /**< Debounced key state, 1 = pressed */
+	uint16_t _longPressSent = 0;          /**< Long press already queued for this press */
+	uint8_t _debounceSamples = 3;         /**< Samples for a key to change state */
+	uint16_t _longPressSamples = 100;     /**< Samples held for a long press, 0 = off */
+
+	repeating_timer_t _timer;             /**< Timer driving the scan */
+	volatile bool _scanning = false;      /**< Timer running */
+	volatile bool _inTick = false;        /**< A sample is being processed */
+	volatile bool _samplePending = false; /**< A sample is due, taken by poll() */
+
+	void pushEvent(uint8_t key, KeyEventType_e type);
+	static bool timerCallback(repeating_timer_t *rt);
+};
+
+#endif
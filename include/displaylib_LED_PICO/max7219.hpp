@@ -10,20 +10,33 @@
 // Libraries
 #include <cstring>
 #include <cstdio> //snprintf
+#include <cstdlib> //abs
 #include "pico/stdlib.h"
 #include "hardware/spi.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/pio.h"
 #include "common_data.hpp"
 #include "seven_segment_font_data.hpp"
+#include "bus_timing.hpp"
 
+#ifndef MAX7219_MAX_CHAIN_LENGTH
+/*! Maximum number of cascaded displays, define at build time for longer chains, RAM use is about 60 bytes per display */
+#define MAX7219_MAX_CHAIN_LENGTH 32
+#endif
 
 /*!
 	@brief  Drive MAX7219 seven segment displays
 */
 class MAX7219plus_model5 : public SevenSegmentFont , public CommonData
 {
+	friend class MAX7219ChainGroup;
+	friend class MAX7219Matrix;
 public:
 	MAX7219plus_model5(uint8_t clock, uint8_t chipSelect, uint8_t data, uint16_t CommDelay);
 	MAX7219plus_model5(uint8_t clock, uint8_t chipSelect, uint8_t data, uint32_t baudrate, spi_inst_t* spiInterface);
+	MAX7219plus_model5(uint8_t clock, uint8_t chipSelect, uint8_t data, uint32_t baudrate, PIO pio);
 
 	/*! The decode-mode register sets BCD code B or no-decode operation for each digit */
 	enum DecodeMode_e : uint8_t
@@ -97,9 +110,12 @@ public:
 
 	uint16_t GetCommDelay(void);
 	void SetCommDelay(uint16_t commDelay);
+	uint32_t GetCommDelayNs(void) const;
+	void SetCommDelayNs(uint32_t commDelayNs);
 	bool GetHardwareSPI(void);
-	uint8_t GetCurrentDisplayNumber(void);
-	void SetCurrentDisplayNumber(uint8_t);
+	bool GetPIOSPI(void);
+	uint16_t GetCurrentDisplayNumber(void);
+	void SetCurrentDisplayNumber(uint16_t);
 
 	void DisplayChar(uint8_t digit, uint8_t value, DecimalPoint_e decimalPoint);
 	int DisplayText(char *text, TextAlignment_e TextAlignment);
@@ -110,6 +126,42 @@ public:
 	int DisplayBCDText(char *text);
 	void SetSegment(uint8_t digit, uint8_t segment);
 
+	// Cascade methods, one CS frame carries a register/data pair for every display
+	void SetChainLength(uint16_t chainLength);
+	uint16_t GetChainLength(void);
+	void SetDeferredMode(bool deferred);
+	bool GetDeferredMode(void);
+	void InitDisplayAll(ScanLimit_e numDigits, DecodeMode_e decodeMode);
+	void ClearDisplayAll(void);
+	void SetBrightnessAll(uint8_t brightness);
+	void ShutdownModeAll(bool OnOff);
+	void DisplayTestModeAll(bool OnOff);
+	void BroadcastRegister(uint8_t RegisterCode, uint8_t data);
+	void WriteAllDisplays(uint8_t RegisterCode, const uint8_t data[]);
+	void WriteCascade(const uint8_t RegisterCodes[], const uint8_t data[]);
+	void RefreshChain(void);
+
+	// Asynchronous flush, hardware SPI only, DMA sends the digit register frames
+	int FlushAsync(void);
+	bool IsFlushBusy(void);
+	void WaitFlush(void);
+	void SetFlushCallback(void (*callback)(void *), void *context = nullptr);
+
+	// Register scrubber, rewrites registers from the shadow to recover from noise
+	uint8_t ScrubRegisters(uint8_t budget);
+	int StartScrubber(uint32_t periodMs, uint8_t budget);
+	void StopScrubber(void);
+
+	// Intensity fade engine, runs from a timer interrupt
+	int FadeTo(const uint8_t targets[], uint32_t durationMs);
+	int FadeAllTo(uint8_t target, uint32_t durationMs);
+	bool IsFading(void);
+	void StopFade(void);
+
+	static constexpr uint16_t MAX7219_MAX_CHAIN = MAX7219_MAX_CHAIN_LENGTH; /**< Maximum number of cascaded displays */
+	static constexpr uint32_t MAX7219_FADE_STEP_MS = 20; /**< Fade timer period mS, 50 steps per second */
+	static constexpr uint32_t MAX7219_PIO_MAX_KHZ = 10000; /**< PIO SPI maximum CLK frequency kHz, MAX7219 rated 10MHz */
+
 protected:
 
 
@@ -120,6 +172,7 @@ private:
 	uint8_t _Display_SCLK;   /**<  GPIO connected to CLK on MAX7219*/
 
 	uint16_t _CommDelay = 0;    /**<  uS delay used in communications SW SPI, User adjust */
+	BusTiming _CommTiming;      /**<  Delay used in communications SW SPI, nS resolution */
 	uint8_t _NoDigits   = 8;    /**<  Number of digits in display */
 	bool _HardwareSPI = false;  /**< Is the Hardware SPI on , true yes , false SW SPI*/
 	spi_inst_t *_pspiInterface;	/**< SPI instance pointer*/
@@ -127,14 +180,78 @@ private:
 
 	DecodeMode_e CurrentDecodeMode; /**< Enum to store current decode mode  */
 
-	uint8_t _CurrentDisplayNumber = 1; /**< Which display the user wishes to write to in a cascade of connected displays*/
+	uint16_t _CurrentDisplayNumber = 1; /**< Which display the user wishes to write to in a cascade of connected displays*/
+	uint16_t _ChainLength = 1;          /**< Number of displays in the cascade */
+	uint16_t _HighestDisplay = 1;       /**< Highest display number selected, frames cover at least this many displays */
+	bool _DeferredMode = false;        /**< true = digit register writes only update the shadow until RefreshChain */
+	uint8_t _RegisterShadow[MAX7219_MAX_CHAIN][16] = {{0}}; /**< Last value written to each register of each display, by register code */
+	uint16_t _FrameBuffer[MAX7219_MAX_CHAIN] = {0};        /**< One chain frame, register/data word per display, NOP when idle */
+
+	int _DMAChannel = -1;                   /**< DMA channel of the asynchronous flush, -1 not claimed */
+	volatile bool _FlushBusy = false;       /**< true while the DMA flush is sending frames */
+	volatile bool _FlushPending = false;    /**< true when the spare buffer holds a flush to send next */
+	uint8_t _FlushActive = 0;               /**< Buffer index the DMA is sending */
+	uint8_t _FlushFrame = 0;                /**< Frame of the active buffer being sent */
+	uint8_t _FlushFrames[2] = {0};          /**< Number of frames in each buffer */
+	uint16_t _FlushChips[2] = {0};          /**< Displays per frame in each buffer */
+	uint16_t _FlushBuffer[2][8][MAX7219_MAX_CHAIN]; /**< Double buffer of digit register frames */
+	void (*_FlushCallback)(void *) = nullptr; /**< Called from the DMA IRQ when a flush completes */
+	void *_FlushCallbackContext = nullptr;    /**< Argument for _FlushCallback */
+
+	PIO _pio = nullptr;  /**< PIO instance running the SPI transmitter, nullptr = not PIO SPI */
+	int _pioSM = -1;     /**< PIO state machine claimed by this instance */
+	static int8_t _pioProgramOffset[2];  /**< Offset of the SPI program in each PIO block, -1 = not loaded */
+	static uint8_t _pioProgramUsers[2];  /**< Number of instances using the program in each PIO block */
+
+	volatile bool _BusActive = false;     /**< true while SendFrame is writing a frame, the scrubber skips its tick */
+	uint8_t _ScrubIndex = 0;              /**< Next register in the scrub cycle */
+	uint8_t _ScrubBudget = 1;             /**< Registers rewritten per scrubber timer tick */
+	bool _ScrubRunning = false;           /**< true while the scrubber timer is running */
+	repeating_timer_t _ScrubTimer;        /**< Scrubber timer */
+	uint16_t _ScrubBuffer[MAX7219_MAX_CHAIN] = {0}; /**< Frame of the scrubber, apart from _FrameBuffer as it runs from the timer IRQ */
+
+	volatile bool _Fading = false;        /**< true while the fade timer is running */
+	uint32_t _FadeStep = 0;               /**< Current fade step */
+	uint32_t _FadeSteps = 1;              /**< Number of fade steps */
+	uint16_t _FadeChips = 1;              /**< Number of displays fading, from display 1 */
+	repeating_timer_t _FadeTimer;         /**< Fade timer */
+	uint8_t _FadeFrom[MAX7219_MAX_CHAIN] = {0};   /**< Intensity of each display at the start of the fade */
+	uint8_t _FadeTarget[MAX7219_MAX_CHAIN] = {0}; /**< Intensity of each display at the end of the fade */
+	uint16_t _FadeBuffer[MAX7219_MAX_CHAIN] = {0}; /**< Frame of the fade engine, written from the timer IRQ */
+
+	/*! Perceived lightness x1000 of each intensity level, duty (2n+1)/32 with gamma 2.2 */
+	static constexpr uint16_t _FadeLightness[16] = {207, 341, 430, 501, 562, 615, 664, 709,
+		750, 789, 826, 861, 894, 926, 956, 986};
+
+	static MAX7219plus_model5 *_DMAOwner[NUM_DMA_CHANNELS]; /**< Instance using each DMA channel, for the shared IRQ handler */
+	static bool _DMAIRQInstalled;                           /**< true once the shared DMA_IRQ_0 handler is added */
 
-	void HighFreqshiftOut(uint8_t value);
+	void HighFreqshiftOut(uint16_t value);
 	void WriteDisplay(uint8_t RegisterCode, uint8_t data);
+	void InitBus(void);
+	uint16_t FrameChips(void);
+	void ClearFrame(uint16_t chips);
+	void SendFrame(const uint16_t *frame, uint16_t chips);
+	/*! @brief Pack a register and data byte into one 16 bit frame word */
+	static constexpr uint16_t FrameWord(uint8_t RegisterCode, uint8_t data) {return (uint16_t)((RegisterCode << 8) | data);}
+	int FlushClaimDMA(void);
+	void FlushReleaseDMA(void);
+	int FlushPrepare(void);
+	bool FlushCommit(uint8_t spare, bool trigger);
+	void FlushStartFrame(void);
+	void FlushFrameDone(void);
+	static void DMAIRQHandler(void);
+	static bool ScrubTimerCallback(repeating_timer_t *timer);
+	int StartFade(uint32_t durationMs);
+	static bool FadeTimerCallback(repeating_timer_t *timer);
+	void FadeTick(void);
+	uint8_t FadeLevel(uint16_t display);
+	bool PIOBegin(void);
+	void PIOClose(void);
+	void PIOWaitIdle(void);
 	uint8_t ASCIIFetch(uint8_t character,DecimalPoint_e decimalPoint);
 	void SetDecodeMode(DecodeMode_e mode);
 	void SetScanLimit(ScanLimit_e numDigits);
-	uint8_t flipBitsPreserveMSB(uint8_t byte);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+/*!
+	@file     max7219_group.hpp
+	@author   Gavin Lyons
+	@brief    PICO library Header file for MAX7219 chains refreshed in parallel on spi0 and spi1.
+*/
+
+#ifndef MAX7219_GROUP_H
+#define MAX7219_GROUP_H
+
+#include "pico/stdlib.h"
+#include <cstdio>
+#include "max7219.hpp"
+
+/*!
+	@brief Class to refresh two MAX7219 hardware SPI chains at the same time.
+	@details Each chain object is constructed as normal on its own SPI instance, spi0 and spi1,
+		initialised, then added to the group. FlushAsync() builds the frames of both chains,
+		then starts both DMA channels with one trigger, so refreshing the group takes as long
+		as the longest chain rather than the sum of both.
+		Completion is tracked per chain.
+*/
+class MAX7219ChainGroup
+{
+
+public:
+	MAX7219ChainGroup(void);
+
+	int AddChain(MAX7219plus_model5 &chain);
+	uint8_t GetChainCount(void) const;
+
+	int FlushAsync(void);
+	bool IsFlushBusy(void) const;
+	bool IsChainBusy(uint8_t chain) const;
+	void WaitFlush(void);
+	void SetFlushCallback(void (*callback)(uint8_t chain, void *context), void *context = nullptr);
+
+	static constexpr uint8_t MAX7219_GROUP_MAX_CHAINS = 2; /**< Maximum number of chains, one per SPI instance */
+
+private:
+	/*! Context passed to the chain completion callback */
+	struct ChainSlot_t
+	{
+		MAX7219ChainGroup *group; /**< Owning group */
+		uint8_t index;            /**< Chain index in the group */
+	};
+
+	MAX7219plus_model5 *_chains[MAX7219_GROUP_MAX_CHAINS] = {nullptr}; /**< Chains in the group */
+	ChainSlot_t _slots[MAX7219_GROUP_MAX_CHAINS];                      /**< Callback context of each chain */
+	uint8_t _chainCount = 0;                                           /**< Number of chains in the group */
+
+	void (*_callback)(uint8_t, void *) = nullptr; /**< Called from the DMA IRQ when a chain completes */
+	void *_callbackContext = nullptr;             /**< Argument for _callback */
+
+	static void ChainDone(void *context);
+};
+
+#endif
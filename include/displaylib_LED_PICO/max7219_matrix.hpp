@@ -0,0 +1,71 @@
+/*!
+	@file     max7219_matrix.hpp
+	@author   Gavin Lyons
+	@brief    PICO library Header file for 8x8 LED matrix modules driven by a MAX7219 chain.
+*/
+
+#ifndef MAX7219_MATRIX_H
+#define MAX7219_MATRIX_H
+
+#include "pico/stdlib.h"
+#include <cstdio>
+#include "max7219.hpp"
+#include "bit_matrix.hpp"
+
+/*!
+	@brief Class to drive a chain of MAX7219 8x8 LED matrix modules as one pixel display.
+	@details The chain object is constructed as normal (software, hardware or PIO SPI)
+		and passed in. The framebuffer is 1 bit per pixel, packed as 8 row strips running
+		across all modules, 32 pixels per word with the leftmost pixel in the MSB, so
+		scrolling is a word-wide shift of each strip.
+		Flush() cuts each module's 8x8 block out of the strips, turns it to the module
+		orientation with a bit matrix transpose, writes it to the chain register shadow
+		and sends one cascade frame per row, 8 frames for the whole chain.
+*/
+class MAX7219Matrix
+{
+
+public:
+	MAX7219Matrix(MAX7219plus_model5 &chain);
+
+	/*! Rotation of the image on each module, clockwise */
+	enum MatrixOrientation_e : uint8_t
+	{
+		MatrixRotate0   = 0, /**< Row 1 register is the top row, bit 7 the left column */
+		MatrixRotate90  = 1, /**< Image turned a quarter clockwise */
+		MatrixRotate180 = 2, /**< Image turned upside down */
+		MatrixRotate270 = 3  /**< Image turned a quarter anticlockwise */
+	};
+
+	int Begin(uint16_t modules);
+	uint16_t GetWidth(void) const;
+	void SetOrientation(MatrixOrientation_e orientation);
+	MatrixOrientation_e GetOrientation(void) const;
+	void SetFirstModuleLeft(bool firstLeft);
+
+	void Clear(void);
+	void SetPixel(uint16_t x, uint8_t y, bool on);
+	bool GetPixel(uint16_t x, uint8_t y) const;
+	void SetColumn(uint16_t x, uint8_t column);
+	void ScrollLeft(uint16_t pixels);
+	void ScrollRight(uint16_t pixels);
+
+	void Flush(void);
+	int FlushAsync(void);
+
+	static constexpr uint16_t MATRIX_MAX_WORDS = (MAX7219plus_model5::MAX7219_MAX_CHAIN * 8 + 31) / 32; /**< Words per row strip */
+
+private:
+	MAX7219plus_model5 *_chain;          /**< Chain driving the modules */
+	uint16_t _modules = 1;               /**< Number of modules */
+	uint16_t _words = 1;                 /**< Words used per row strip */
+	MatrixOrientation_e _orientation = MatrixRotate0; /**< Module orientation */
+	bool _firstLeft = false;             /**< true display 1 (nearest the PICO) is the leftmost module */
+	uint32_t _rows[8][MATRIX_MAX_WORDS] = {{0}}; /**< Row strips, pixel x in word x/32, bit 31-(x%32) */
+
+	void MaskTail(void);
+	uint64_t ModuleBlock(uint16_t module) const;
+	void UpdateShadow(void);
+};
+
+#endif
@@ -7,16 +7,82 @@
 #define SEVENSEG_COMMON_H
 
 #include <cstdint>
+#include <array>
+
+/*! Bit order of the segments in a font byte, bit 7 is always the decimal point */
+enum class SegmentOrder_e : uint8_t
+{
+	DpGFEDCBA = 0, /**< a in bit 0 , g in bit 6, font data order, TM1638 TM1637 HT16K33 */
+	DpABCDEFG = 1  /**< g in bit 0 , a in bit 6, MAX7219 no decode mode */
+};
 
 /*!
 	@class SevenSegmentFont
 	@brief Class that provides access to a seven-segment font data table.
+	@details The font data is held once in dp-gfedcba order, tables in other bit orders
+		are generated from it at compile time, see pFontSevenSegptr<ORDER>().
  */
 class SevenSegmentFont {
 protected:
 	static const uint8_t* pFontSevenSegptr();
+
+	/*!
+		@brief Retrieves a pointer to the seven-segment font data table in a driver's native bit order.
+		@tparam ORDER bit order of the segments
+		@return Pointer to the font data array, generated at compile time.
+	*/
+	template <SegmentOrder_e ORDER>
+	static const uint8_t* pFontSevenSegptr() {return fontTable<ORDER>.data();}
+
 private:
-	static const uint8_t fontData[];
+	static constexpr uint8_t _FONT_SIZE = 91; /**< Number of characters in the font */
+
+	/*!
+		@brief Font data table for ASCII values mapped to seven-segment representation.
+			Offset starts at ASCII value 32 (space).
+			Encoded in dp-gfedcba bit order. In the header so other bit orders can be built from it at compile time.
+	*/
+	static constexpr uint8_t fontData[_FONT_SIZE] = {
+		0x00, 0x86, 0x22, 0x7E, 0x6D, 0xD2, 0x46, 0x20, 0x29, 0x0B, /* space - ) */
+		0x21, 0x70, 0x10, 0x40, 0x80, 0x52, 0x3F, 0x06, 0x5B, 0x4F, /* * - 3 */
+		0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F, 0x09, 0x0D, 0x61, 0x48, /* 4 - = */
+		0x43, 0xD3, 0x5F, 0x77, 0x7C, 0x39, 0x5E, 0x79, 0x71, 0x3D, /* > - G */
+		0x76, 0x30, 0x1E, 0x75, 0x38, 0x15, 0x37, 0x3F, 0x73, 0x6B, /* H - Q */
+		0x33, 0x6D, 0x78, 0x3E, 0x3E, 0x2A, 0x76, 0x6E, 0x5B, 0x39, /* R - [ */
+		0x64, 0x0F, 0x23, 0x08, 0x02, 0x5F, 0x7C, 0x58, 0x5E, 0x7B, /* \ - e */
+		0x71, 0x6F, 0x74, 0x10, 0x0C, 0x75, 0x30, 0x14, 0x54, 0x5C, /* f - o */
+		0x73, 0x67, 0x50, 0x6D, 0x78, 0x1C, 0x1C, 0x14, 0x76, 0x6E, /* p - y */
+		0x5B                                                        /* z  */
+	};
+
+	/*!
+		@brief Re-encode one dp-gfedcba font byte in another bit order
+		@param value font byte, dp-gfedcba
+		@param order target bit order
+		@return font byte in target order
+	*/
+	static constexpr uint8_t reorder(uint8_t value, SegmentOrder_e order)
+	{
+		if (order == SegmentOrder_e::DpGFEDCBA) return value;
+		uint8_t result = value & 0x80; // decimal point stays in bit 7
+		for (uint8_t segment = 0; segment < 7; segment++)
+		{
+			if (value & (1 << segment)) result |= (1 << (6 - segment));
+		}
+		return result;
+	}
+
+	/*! Font table in bit order ORDER, built from fontData at compile time */
+	template <SegmentOrder_e ORDER>
+	static constexpr std::array<uint8_t, _FONT_SIZE> fontTable = []
+	{
+		std::array<uint8_t, _FONT_SIZE> table{};
+		for (uint8_t i = 0; i < _FONT_SIZE; i++)
+		{
+			table[i] = reorder(fontData[i], ORDER);
+		}
+		return table;
+	}();
 };
 
-#endif
\ No newline at end of file
+#endif
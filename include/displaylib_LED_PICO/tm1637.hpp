@@ -14,15 +14,19 @@
 #include "pico/stdlib.h"
 #include "common_data.hpp"
 #include "seven_segment_font_data.hpp"
+#include "bus_timing.hpp"
+#include "hardware/pio.h"
 
 /*!
 	@brief Class for TM1637 Model 4
 */
 class TM1637plus_model4 : public SevenSegmentFont , public CommonData{
+	friend class TM1637plus_keyscan;
+	friend class TM1637Group;
 
 public:
 
-	TM1637plus_model4 (uint8_t clock, uint8_t data , int delay, int DisplaySize) ;
+	TM1637plus_model4 (uint8_t clock, uint8_t data , int delay, int DisplaySize, PIO pio = nullptr, const uint8_t *digitMap = nullptr) ;
 	void displayBegin(void);
 	void displayClose(void);
 	void displayClear(void);
@@ -33,25 +37,118 @@ public:
 	void DisplayDecimalwDot(int num, uint8_t dots , bool leading_zero ,uint8_t length , uint8_t pos );
 	int DisplayString(const char* numStr, uint8_t dots , uint8_t length, uint8_t position);
 	unsigned char encodeCharacter(unsigned char digit);
+	void setBitDelayNs(uint32_t delayNs);
+	uint32_t getBitDelayNs(void) const;
+	bool isPIOTransport(void) const;
+	uint32_t getAckFailures(void);
+	void clearAckFailures(void);
+	void forceResync(void);
+	bool getDeferredMode(void) const;
+	void setAsyncMode(bool async);
+	bool getAsyncMode(void) const;
+	bool isBusy(void) const;
+	void waitIdle(void);
+	void setCompletionCallback(void (*callback)(void *), void *context = nullptr);
+	int calibrate(uint8_t margin = 50);
+	uint32_t getRiseTimeNs(void) const;
+	uint32_t getCalibratedDelayNs(void) const;
+	void setCalibratedDelayNs(uint32_t delayNs);
+	uint8_t readKeyCode(void);
+	uint8_t readKey(void);
+
+	static constexpr uint8_t TM1637_NO_KEY = 0xFF; /**< readKey / readKeyCode value when no key is pressed */
+	static constexpr uint8_t TM1637_DIGIT_MAP_6[6] = {2, 1, 0, 5, 4, 3}; /**< Digit to grid address map of common 6 digit modules */
 
 protected:
 
 private:
 
+	const uint8_t _TM1637_COMMAND_1    = 0x40;   /**< Automatic data incrementing */
+	const uint8_t _TM1637_COMMAND_2    = 0xC0;  /**< Data Data1~N: Transfer display data */
+	const uint8_t _TM1637_COMMAND_3    = 0x80;  /**< Display intensity */
+	const uint8_t _TM1637_COMMAND_READ = 0x42;  /**< Read key scan data */
+	static constexpr uint8_t _TM1637_MAX_DIGITS = 6;  /**< Size of TM1637 display RAM in digits */
+	static constexpr uint32_t _TM1637_PIO_BUS_HZ = 250000; /**< PIO transport CLK frequency, TM1637 rated maximum 250kHz */
+	static constexpr uint32_t _TM1637_MIN_DELAY_NS = 1000000000 / (2 * _TM1637_PIO_BUS_HZ); /**< Half period of the rated 250kHz CLK, calibrate adds the rise time to it */
+	static constexpr uint8_t _TM1637_CAL_SAMPLES = 8;  /**< Rise time samples per line */
+	static constexpr uint8_t _TM1637_CAL_FRAMES = 16;  /**< Test frames per delay step */
+
 	uint8_t _DATA_IO; /**<  GPIO connected to DIO on Tm1637  */
 	uint8_t _CLOCK_IO; /**<  GPIO connected to CLk on Tm1637  */
 	uint8_t _DisplaySize = 4; /**< size of display in digits */
-	int _BitDelayUS = 75; /**< Us second delay used in communications */
+	uint8_t _digitMap[_TM1637_MAX_DIGITS] = {0, 1, 2, 3, 4, 5}; /**< Grid address of each display digit, left to right */
+	uint8_t _frame[_TM1637_MAX_DIGITS] = {0}; /**< Shadow of the TM1637 display RAM, in grid address order */
+	bool _deferredMode = false; /**< true = setSegments only updates the shadow frame */
+	BusTiming _BitDelay{75000}; /**< Delay used in communications, default 75uS */
 	uint8_t _brightness; /**< Brightness level 0-7*/
+	uint32_t _ackFailures = 0; /**< Number of bytes not acknowledged by the TM1637 */
+	int16_t _lastDataCommand = -1;    /**< Data command last sent to the TM1637, -1 = unknown */
+	int16_t _lastDisplayControl = -1; /**< Display control command last sent to the TM1637, -1 = unknown */
+	uint32_t _riseTimeNs = 0;       /**< Slowest CLK/DIO rise time measured by calibrate */
+	uint32_t _calibratedDelayNs = 0; /**< Bit delay picked by calibrate, 0 = not calibrated */
 
-	const uint8_t _TM1637_COMMAND_1    = 0x40;   /**< Automatic data incrementing */
-	const uint8_t _TM1637_COMMAND_2    = 0xC0;  /**< Data Data1~N: Transfer display data */
-	const uint8_t _TM1637_COMMAND_3    = 0x80;  /**< Display intensity */
+	/*! Bus edges of the asynchronous transmitter, one per alarm interrupt */
+	enum AsyncStep_e : uint8_t
+	{
+		StepStart,        /**< DIO low, start condition */
+		StepClockLow,     /**< CLK low before a data bit */
+		StepData,         /**< DIO set to the data bit */
+		StepClockHigh,    /**< CLK high, bit latched */
+		StepAckClockLow,  /**< CLK low, DIO released for the ACK */
+		StepAckClockHigh, /**< CLK high, 9th clock */
+		StepAckRead,      /**< Sample the ACK */
+		StepAckEnd,       /**< CLK low, end of ACK */
+		StepStopData,     /**< DIO low */
+		StepStopClock,    /**< CLK released */
+		StepStopRelease   /**< DIO released, stop condition */
+	};
+
+	bool _asyncMode = false;          /**< true = setSegments queues the frames for the alarm IRQ */
+	volatile bool _asyncBusy = false; /**< Asynchronous transmitter running */
+	void (*_asyncCallback)(void *) = nullptr; /**< Called from the IRQ when the transmitter goes idle */
+	void *_asyncCallbackContext = nullptr;    /**< Argument for _asyncCallback */
+	uint32_t _asyncDelayUs = 75;      /**< Alarm period, bit delay rounded up to microseconds */
+	volatile bool _mailboxFull = false; /**< A frame is waiting for the transmitter, latest wins */
+	uint8_t _mailbox[_TM1637_MAX_DIGITS + 1]; /**< Waiting address + data frame */
+	uint8_t _mailboxLength = 0;       /**< Bytes in _mailbox */
+	uint8_t _txFrames[3][_TM1637_MAX_DIGITS + 1]; /**< Frames of the job in progress */
+	uint8_t _txLengths[3];            /**< Bytes in each frame of the job */
+	uint8_t _txFrameCount = 0;        /**< Frames in the job */
+	uint8_t _txFrame = 0;             /**< Frame being sent */
+	uint8_t _txByte = 0;              /**< Byte being sent */
+	uint8_t _txBit = 0;               /**< Bit being sent */
+	bool _txNack = false;             /**< true if a byte of the frame being sent was not acknowledged */
+	AsyncStep_e _txStep = StepStart;  /**< Next bus edge */
+
+	volatile bool _busActive = false;   /**< A blocking frame is on the bus */
+	volatile bool _scanPending = false; /**< A key scan was deferred while the bus was busy */
+	void (*_scanHook)(void *) = nullptr; /**< Called to take a deferred key scan */
+	void *_scanHookContext = nullptr;    /**< Argument for _scanHook */
+
+	PIO _pio = nullptr; /**< PIO instance running the bus engine, nullptr = bit-banged GPIO */
+	int _pioSM = -1;    /**< PIO state machine claimed by this instance */
+	static int8_t _pioProgramOffset[2];  /**< Offset of the bus engine program in each PIO block, -1 = not loaded */
+	static uint8_t _pioProgramUsers[2];  /**< Number of instances using the program in each PIO block */
 
 	void CommBitDelay(void);
 	void CommStart(void);
 	void CommStop(void);
 	bool writeByte(uint8_t byte);
+	uint8_t readByte(void);
+	uint8_t gridCount(void) const;
+	void setDeferredMode(bool deferred);
+	uint32_t measureRiseNs(uint8_t gpio);
+	bool ackTest(void);
+	void busRelease(void);
+	bool scanKeys(uint16_t &keys);
+	void writeFrame(const uint8_t *data, uint8_t length);
+	void drainAcks(void);
+	void asyncLoadJob(void);
+	int64_t asyncStep(void);
+	static int64_t asyncAlarm(alarm_id_t id, void *userData);
+	bool PIOBegin(void);
+	void PIOClose(void);
+	void PIOWaitIdle(void);
 
 };
 
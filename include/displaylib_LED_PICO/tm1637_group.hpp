@@ -0,0 +1,53 @@
+/*!
+	@file     tm1637_group.hpp
+	@author   Gavin Lyons
+	@brief    PICO library Header file for several TM1637 modules sharing one CLK line.
+*/
+
+#ifndef TM1637_GROUP_H
+#define TM1637_GROUP_H
+
+#include "pico/stdlib.h"
+#include <cstdio>
+#include "tm1637.hpp"
+
+/*!
+	@brief Class to drive up to 8 TM1637 modules on a shared CLK, one DIO line each.
+	@details Each module object is constructed as normal with the shared CLK GPIO and
+		its own DIO GPIO, then added to the group. The TM1637 has no addressing, so all
+		modules are clocked together, every DIO line is driven in one masked write per
+		bit and all ACKs are sampled in one read, each module gets its own bytes.
+		Updating 8 modules takes the same bus time as updating one.
+*/
+class TM1637Group
+{
+
+public:
+	TM1637Group(uint8_t clock);
+
+	int addModule(TM1637plus_model4 &module);
+	uint8_t getModuleCount(void) const;
+
+	void displayBegin(void);
+	void displayClose(void);
+	uint8_t flush(void);
+	void setBitDelayNs(uint32_t delayNs);
+	uint32_t getBitDelayNs(void) const;
+
+	static constexpr uint8_t TM_GROUP_MAX_MODULES = 8; /**< Maximum number of modules in a group */
+
+private:
+	static constexpr uint8_t TM_GROUP_FRAME_SIZE = 7; /**< Largest frame, address + 6 grids */
+
+	uint8_t _CLOCK_IO; /**< GPIO connected to CLK on all modules */
+	BusTiming _BitDelay{75000}; /**< Delay between bus edges, largest module delay once modules are added */
+
+	TM1637plus_model4 *_modules[TM_GROUP_MAX_MODULES] = {nullptr}; /**< Modules in the group */
+	uint8_t _moduleCount = 0; /**< Number of modules in the group */
+	uint32_t _dataMask = 0;   /**< GPIO mask of all DIO lines */
+
+	uint8_t writeFrameAll(const uint8_t frames[][TM_GROUP_FRAME_SIZE], uint8_t length);
+	uint32_t lowMask(const uint8_t frames[][TM_GROUP_FRAME_SIZE], uint8_t byte, uint8_t bit) const;
+};
+
+#endif
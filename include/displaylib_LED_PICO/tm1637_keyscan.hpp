@@ -0,0 +1,39 @@
+/*!
+	@file     tm1637_keyscan.hpp
+	@author   Gavin Lyons
+	@brief    PICO library Header file, background key scanner for TM1637 modules.
+*/
+
+#ifndef TM1637_KEYSCAN_H
+#define TM1637_KEYSCAN_H
+
+#include "pico/stdlib.h"
+#include "key_scanner.hpp"
+#include "tm1637.hpp"
+
+/*!
+	@brief Background key scanner for the TM1637 8x2 key matrix.
+	@details Key numbers are those of TM1637plus_model4::readKey, K1 SG1-SG8 = 0-7,
+		K2 SG1-SG8 = 8-15. The TM1637 reports one key at a time, so only one
+		key is down in each sample. A key read is a slow bit-banged frame, so the
+		timer only marks a sample due, call poll() from the main loop to take it.
+		A sample that falls while the display is being written is deferred
+		until the write ends.
+*/
+class TM1637plus_keyscan : public KeyScanner
+{
+
+public:
+	TM1637plus_keyscan(TM1637plus_model4 &module);
+	~TM1637plus_keyscan();
+
+protected:
+	bool readKeys(uint16_t &keys) override;
+
+private:
+	TM1637plus_model4 *_module; /**< Module being scanned */
+
+	static void deferredScan(void *context);
+};
+
+#endif
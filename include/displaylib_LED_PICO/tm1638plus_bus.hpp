@@ -0,0 +1,56 @@
+/*!
+	@file     tm1638plus_bus.hpp
+	@author   Gavin Lyons
+	@brief    PICO library Header file for several TM1638 modules sharing one CLK/DIO bus.
+*/
+
+#ifndef TM1638PLUS_BUS_H
+#define TM1638PLUS_BUS_H
+
+#include "pico/stdlib.h"
+#include <cstdio>
+#include "tm1638plus_common.hpp"
+
+/*!
+	@brief Class to drive up to 8 TM1638 modules on a shared CLK & DIO, one STB line each.
+	@details Each module object is constructed as normal with the shared CLK and DIO GPIO
+		and its own STB GPIO, then added to the bus. The bus owns pin setup,
+		broadcasts commands by asserting several strobes at once and flushes
+		the modules shadow display RAM back to back. Any transfer on the bus, including
+		a direct flush() or key read of one module, locks every module on it,
+		so a key scan of another module waits for the bus to be free.
+*/
+class TM1638Bus
+{
+	friend class TM1638plus_common;
+
+public:
+	// Constructor
+	TM1638Bus(uint8_t clock, uint8_t data);
+
+	int addModule(TM1638plus_common &module);
+	uint8_t getModuleCount(void) const;
+
+	void displayBegin(void);
+	void displayClose(void);
+	void reset(void);
+	void brightness(uint8_t brightness);
+	void sendCommand(uint8_t value);
+	uint16_t flush(bool fullImage = false);
+
+	static constexpr uint8_t TM_BUS_MAX_MODULES = 8; /**< Maximum number of modules on one bus */
+
+private:
+	uint8_t _CLOCK_IO; /**<  GPIO connected to CLK on all modules  */
+	uint8_t _DATA_IO;  /**<  GPIO connected to DIO on all modules  */
+
+	TM1638plus_common *_modules[TM_BUS_MAX_MODULES] = {nullptr}; /**< Modules on the bus */
+	uint8_t _moduleCount = 0;  /**< Number of modules on the bus */
+	uint32_t _strobeMask = 0;  /**< GPIO mask of all STB lines */
+
+	void sendFrameAll(const uint8_t *data, uint8_t length);
+	void lockAll(void);
+	void unlockAll(void);
+};
+
+#endif
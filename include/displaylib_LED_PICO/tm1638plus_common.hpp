@@ -7,51 +7,77 @@
 #ifndef TM1638PLUS_COMMON_H
 #define TM1638PLUS_COMMON_H
 
-#include "common_data.hpp"
-#include "seven_segment_font_data.hpp"
+#include "tm1638plus_core.hpp"
+#include "bus_timing.hpp"
+#include "hardware/pio.h"
 #include <cstdio>
 
+class TM1638Bus;
+
 /*!
 	@brief  The base Class , used to store common data & functions for all models types.
 */
-class TM1638plus_common : public SevenSegmentFont , public CommonData
+class TM1638plus_common : public TM1638plus_core
 {
+	friend class TM1638Bus;
+	friend class TM1638plus_keyscan;
 
 public:
 	// Constructor
-	TM1638plus_common(uint8_t strobe, uint8_t clock, uint8_t data);
+	TM1638plus_common(uint8_t strobe, uint8_t clock, uint8_t data, PIO pio = nullptr);
 
 	void displayBegin(void);
 	void displayClose(void);
 	void reset(void);
 	void brightness(uint8_t brightness);
+	bool isPIOTransport(void) const;
+	void setDeferredMode(bool deferred);
+	bool getDeferredMode(void) const;
+	uint8_t flush(bool fullImage = false);
+	uint8_t getFlushBusBytes(void) const;
+	uint32_t getTotalBusBytes(void) const;
+	void setBusDelayNs(uint32_t delayNs);
+	uint32_t getBusDelayNs(void) const;
 
 protected:
 	uint8_t _STROBE_IO; /**<  GPIO connected to STB on Tm1638  */
 	uint8_t _DATA_IO;	/**<  GPIO connected to DIO on Tm1638  */
 	uint8_t _CLOCK_IO;	/**<  GPIO connected to CLk on Tm1638  */
 
-	uint8_t _HFIN_DELAY = 1;  /**<  uS Delay used by shiftIn function for High-freq MCU  */
-	uint8_t _HFOUT_DELAY = 1; /**<  uS Delay used by shiftOut function for High-freq MCU */
-
-	// Commands list and defaults
-	static constexpr uint8_t TM_ACTIVATE = 0x8F;		   /**< Start up device */
-	static constexpr uint8_t TM_BUTTONS_MODE = 0x42;	   /**< Buttons mode */
-	static constexpr uint8_t TM_WRITE_LOC = 0x44;		   /**< Write to a memory location */
-	static constexpr uint8_t TM_WRITE_INC = 0x40;		   /**< Incremental write */
-	static constexpr uint8_t TM_SEG_ADR = 0xC0;			   /**< Leftmost segment Address C0 C2 C4 C6 C8 CA CC CE */
-	static constexpr uint8_t TM_LEDS_ADR = 0xC1;		   /**< Leftmost LED address C1 C3 C5 C7 C9 CB CD CF */
-	static constexpr uint8_t TM_BRIGHT_ADR = 0x88;		   /**< Brightness address */
-	static constexpr uint8_t TM_BRIGHT_MASK = 0x07;		   /**< Brightness mask */
-	static constexpr uint8_t TM_DEFAULT_BRIGHTNESS = 0x02; /**< Brightness can be 0x00 to 0x07, 0x00 is least bright */
-	static constexpr uint8_t TM_DISPLAY_SIZE = 8;		   /**< Size of display in digits */
+	BusTiming _busDelay{TM_HALF_BIT_NS}; /**< Half bit delay used by the shiftIn and shiftOut functions */
+
+	PIO _pio = nullptr; /**< PIO instance running the bus engine, nullptr = bit-banged GPIO */
+	int _pioSM = -1;    /**< PIO state machine claimed by this instance */
+
+	static constexpr uint32_t TM_PIO_BUS_HZ = 1000000;     /**< PIO transport CLK frequency, TM1638 rated maximum 1MHz */
+
+	volatile uint8_t _busLock = 0;      /**< Nesting count of bus transfers in progress */
+	volatile bool _scanPending = false; /**< A key scan was deferred while the bus was busy */
+	void (*_scanHook)(void *) = nullptr; /**< Called to take a deferred key scan */
+	void *_scanHookContext = nullptr;    /**< Argument for _scanHook */
+	TM1638Bus *_bus = nullptr;           /**< Shared bus the module was added to, nullptr = own bus */
 
 	uint8_t HighFreqshiftin(uint8_t dataPin, uint8_t clockPin);
 	void HighFreqshiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t val);
 	void sendCommand(uint8_t value);
 	void sendData(uint8_t data);
+	void sendFrame(const uint8_t *data, uint8_t length);
+	void readFrame(uint8_t *data, uint8_t length);
+	void writeDisplayRAM(uint8_t address, uint8_t value);
+	void busAcquire(void);
+	void busRelease(void);
+	void busLock(void);
+	void busUnlock(void);
+	bool scanKeys(uint16_t &keys);
+	virtual uint16_t readKeyMatrix(void);
 
 private:
+	static int8_t _pioProgramOffset[2];  /**< Offset of the bus engine program in each PIO block, -1 = not loaded */
+	static uint8_t _pioProgramUsers[2];  /**< Number of instances using the program in each PIO block */
+
+	bool PIOBegin(void);
+	void PIOClose(void);
+	void PIOWaitIdle(void);
 };
 
 #endif
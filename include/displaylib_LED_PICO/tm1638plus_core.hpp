@@ -0,0 +1,268 @@
+/*!
+	@file     tm1638plus_core.hpp
+	@author   Gavin Lyons
+	@brief    tm1638 PICO driver. Header file for the protocol logic shared by the model classes
+		and the TM1638plus_fast template.
+*/
+
+#ifndef TM1638PLUS_CORE_H
+#define TM1638PLUS_CORE_H
+
+#include <cstdio>
+#include <cstring>
+#include "pico/stdlib.h"
+#include "common_data.hpp"
+#include "seven_segment_font_data.hpp"
+#include "bit_matrix.hpp"
+
+/*!
+	@brief Transport independent TM1638 logic : commands, shadow display RAM,
+		flush cost model, text rendering and key decoding.
+	@details Base of TM1638plus_common (model classes) and TM1638plus_fast, which only
+		add the bus transport, so both drivers send the same frames and decode the same keys.
+*/
+class TM1638plus_core : public SevenSegmentFont, public CommonData
+{
+
+public:
+	/*! Tm1638 bi-color LED colors, model 3 */
+	enum TMLEDColors : uint8_t
+	{
+		TM_RED_LED = 0x02,   /**< Turn on Red LED*/
+		TM_GREEN_LED = 0x01, /**< Turn on Green LED*/
+		TM_OFF_LED = 0x00    /**< Turn off  LED*/
+	};
+
+protected:
+	// Commands list and defaults
+	static constexpr uint8_t TM_ACTIVATE = 0x8F;		   /**< Start up device */
+	static constexpr uint8_t TM_BUTTONS_MODE = 0x42;	   /**< Buttons mode */
+	static constexpr uint8_t TM_WRITE_LOC = 0x44;		   /**< Write to a memory location */
+	static constexpr uint8_t TM_WRITE_INC = 0x40;		   /**< Incremental write */
+	static constexpr uint8_t TM_SEG_ADR = 0xC0;			   /**< Leftmost segment Address C0 C2 C4 C6 C8 CA CC CE */
+	static constexpr uint8_t TM_LEDS_ADR = 0xC1;		   /**< Leftmost LED address C1 C3 C5 C7 C9 CB CD CF */
+	static constexpr uint8_t TM_BRIGHT_ADR = 0x88;		   /**< Brightness address */
+	static constexpr uint8_t TM_BRIGHT_MASK = 0x07;		   /**< Brightness mask */
+	static constexpr uint8_t TM_DEFAULT_BRIGHTNESS = 0x02; /**< Brightness can be 0x00 to 0x07, 0x00 is least bright */
+	static constexpr uint8_t TM_DISPLAY_SIZE = 8;		   /**< Size of display in digits */
+	static constexpr uint8_t TM_RAM_SIZE = 16;		   /**< Size of display RAM, addresses C0-CF */
+	static constexpr uint32_t TM_HALF_BIT_NS = 500;        /**< Default GPIO half bit delay nS, CLK pulse width minimum is 400nS */
+	static constexpr uint32_t TM_READ_WAIT_US = 2;         /**< Wait after the read command before DIO is read, Twait minimum is 1uS */
+
+	uint8_t _displayRAM[TM_RAM_SIZE] = {0}; /**< Shadow of TM1638 display RAM, segments even addresses, LEDs odd */
+	uint8_t _chipRAM[TM_RAM_SIZE] = {0};    /**< Copy of what was last written to the TM1638 display RAM */
+	uint16_t _dirtyMask = 0;     /**< One bit per display RAM address that differs from the chip */
+	bool _deferredMode = false; /**< true = writes only update the shadow RAM until flush() is called */
+	uint8_t _flushBusBytes = 0;  /**< Bus bytes emitted by the last flush */
+	uint32_t _totalBusBytes = 0; /**< Bus bytes emitted by all flushes since displayBegin */
+
+	/*!
+		@brief Update one byte of the shadow display RAM
+		@param address display RAM offset 0x00-0x0F , segments even, LEDs odd
+		@param value data byte
+		@return true if the caller should flush now, deferred mode is off
+		@note Marks the address dirty if it differs from the chip.
+	*/
+	bool storeDisplayRAM(uint8_t address, uint8_t value)
+	{
+		address &= (TM_RAM_SIZE - 1);
+		_displayRAM[address] = value;
+		if (value != _chipRAM[address])
+			_dirtyMask |= (1 << address);
+		else
+			_dirtyMask &= ~(1 << address);
+		return (_deferredMode == false);
+	}
+
+	/*!
+		@brief Write the dirty addresses of the shadow display RAM with the cheapest frames
+		@param sendFrame transport, called as sendFrame(const uint8_t *data, uint8_t length)
+			for each frame, STB low for the whole frame
+		@return Number of bytes put on the bus, 0 if nothing changed.
+		@details The cheapest of two methods is picked by counting bus bytes:
+			-# fixed address : TM_WRITE_LOC command + (address + data) per dirty address, 1 + 2n bytes.
+			-# auto increment : TM_WRITE_INC command + start address + every byte from
+			first to last dirty address, 2 + span bytes.
+			On a tie auto increment wins as it needs fewer strobe frames.
+			A full image is 18 bytes.
+	*/
+	template <typename SendFrame>
+	uint8_t flushDirty(SendFrame sendFrame)
+	{
+		if (_dirtyMask == 0)
+		{
+			_flushBusBytes = 0;
+			return 0;
+		}
+		uint8_t first = __builtin_ctz(_dirtyMask);
+		uint8_t last = 31 - __builtin_clz(_dirtyMask);
+		uint8_t span = last - first + 1;
+		uint8_t costFixed = 1 + 2 * __builtin_popcount(_dirtyMask);
+		uint8_t costIncrement = 2 + span;
+
+		if (costIncrement <= costFixed)
+		{
+			uint8_t command = TM_WRITE_INC; // set auto increment mode
+			uint8_t frame[TM_RAM_SIZE + 1];
+			frame[0] = TM_SEG_ADR + first;
+			memcpy(&frame[1], &_displayRAM[first], span);
+			sendFrame(&command, 1);
+			sendFrame(frame, span + 1);
+			_flushBusBytes = costIncrement;
+		} else
+		{
+			uint8_t command = TM_WRITE_LOC; // set fixed address mode
+			sendFrame(&command, 1);
+			for (uint8_t address = first; address <= last; address++)
+			{
+				if ((_dirtyMask & (1 << address)) == 0) continue;
+				uint8_t frame[2] = {(uint8_t)(TM_SEG_ADR + address), _displayRAM[address]};
+				sendFrame(frame, sizeof(frame));
+			}
+			_flushBusBytes = costFixed;
+		}
+		memcpy(_chipRAM, _displayRAM, TM_RAM_SIZE);
+		_dirtyMask = 0;
+		_totalBusBytes += _flushBusBytes;
+		return _flushBusBytes;
+	}
+
+	/*!
+		@brief Seven segment data of an ASCII character, model 1 & 3
+		@param ascii The ASCII value from font table, outside the font '0' is shown
+		@param decimalPoint decimal point or off on the digit.
+		@return segments (dp)gfedcba
+	*/
+	static uint8_t digitSegments(uint8_t ascii, DecimalPoint_e decimalPoint)
+	{
+		if (ascii < _ASCII_FONT_OFFSET || ascii >= _ASCII_FONT_END)
+		{
+			printf("Warning : displayASCII : ASCII character is outside font range %u, \n", ascii);
+			ascii = '0';
+		} // check ASCII font bounds
+		uint8_t value = pFontSevenSegptr()[ascii - _ASCII_FONT_OFFSET];
+		if (decimalPoint == DecPointOn) value |= DEC_POINT_7_MASK; // turn on decimal point/dot in seven seg
+		return value;
+	}
+
+	/*!
+		@brief Render a text string to digit data, model 1 & 3
+		@param text pointer to a character array, not null
+		@param values eight digits of segment data, filled from digit 0
+		@return number of digits filled, digits past it are left for the display to keep
+		@note Dots are removed from string and dot on preceding digit switched on
+			"abc.def" is rendered as "abcdef" with c decimal point turned on.
+	*/
+	static uint8_t textToDigits(const char *text, uint8_t values[TM_DISPLAY_SIZE])
+	{
+		char c;
+		uint8_t pos = 0;
+		while ((c = (*text++)) && pos < TM_DISPLAY_SIZE)
+		{
+			if (*text == '.' && c != '.')
+			{
+				values[pos++] = digitSegments(c, DecPointOn);
+				text++;
+			} else
+			{
+				values[pos++] = digitSegments(c, DecPointOff);
+			}
+		}
+		return pos;
+	}
+
+	/*!
+		@brief Render a string to digit data with a decimal point mask, model 2
+		@param string pointer to a character array, not null, up to 8 characters
+		@param dots decimal points 0 to 0xFF d7d6d5d4d3d2d1d0, bit 7 = first digit
+		@param values eight digits of segment data, digits past the string are blank
+		@return 0 for success, -4 for ascii character outside font range
+	*/
+	static int stringToDigits(const char *string, uint16_t dots, uint8_t values[TM_DISPLAY_SIZE])
+	{
+		const uint8_t *font = pFontSevenSegptr();
+		bool done = false;
+		for (uint8_t i = 0; i < TM_DISPLAY_SIZE; i++)
+		{
+			values[i] = 0;
+			if (!done && string[i] != '\0')
+			{
+				if (string[i] < _ASCII_FONT_OFFSET || string[i] >= _ASCII_FONT_END)
+				{
+					printf("Error: DisplayStr: Character '%c' (ASCII %u) is outside font range.\n", string[i], string[i]);
+					return -4; // Error: Invalid character outside font range
+				}
+				values[i] = font[string[i] - _ASCII_FONT_OFFSET];
+			} else
+			{
+				done = true;
+			}
+			// if dots bit is set for that position apply the mask to turn on dot(0x80).
+			if ((dots >> (7 - i)) & 1) values[i] |= DEC_POINT_7_MASK;
+		}
+		return 0;
+	}
+
+	/*!
+		@brief Convert eight digit bytes to eight segment bytes, model 2
+		@param values eight digits of segment data, first digit left
+		@param swapNibbles swap the nibbles of each segment byte
+		@return byte r = segment r (abcdefg(dp) = 01234567), first digit in the MSB
+		@note The digits are packed into a uint64_t in reverse order, so the first digit lands in
+			the MSB of each segment byte, transposed, and nibble swapped if required.
+	*/
+	static uint64_t digitsToSegments(const uint8_t values[TM_DISPLAY_SIZE], bool swapNibbles)
+	{
+		uint64_t matrix;
+		memcpy(&matrix, values, TM_DISPLAY_SIZE);
+		matrix = __builtin_bswap64(matrix); // byte r = digit 7-r
+		matrix = BitMatrix::transpose8x8(matrix); // byte r = segment r
+		if (swapNibbles == true)
+		{
+			matrix = BitMatrix::swapNibbles(matrix);
+		}
+		return matrix;
+	}
+
+	/*!
+		@brief Decode the key scan bytes of the 8 button modules, model 1 & 3
+		@param keyScan four key scan bytes
+		@return buttons 1-8 in bits 0-7, 1 pressed
+	*/
+	static uint8_t decodeButtons(const uint8_t keyScan[4])
+	{
+		uint8_t buttons = 0;
+		for (uint8_t i = 0; i < 4; i++)
+		{
+			buttons |= keyScan[i] << i;
+		}
+		return buttons;
+	}
+
+	/*!
+		@brief Decode the key scan bytes of the 16 button module, model 2
+		@param keyScan four key scan bytes
+		@return buttons S1-S16 in bits 0-15, 1 pressed
+		@note
+			Data matrix for read key_value. c = datain
+			c3 0110 0110  c2 0110 0110  c1 0110 0110  c0 0110 0110 :bytes read
+			8,16 7,15     6,14 5,13     4,12 3,11      2,10  1,9 :button value
+	*/
+	static uint16_t decodeKeys16(const uint8_t keyScan[4])
+	{
+		uint16_t key_value = 0;
+		for (uint8_t i = 0; i < 4; i++)
+		{
+			uint8_t Datain = keyScan[i];
+			// turn Datain ABCDEFGI = 0BC00FG0  into 00CG00BF
+			Datain = (((Datain & 0x40) >> 3 | (Datain & 0x04)) >> 2) | (Datain & 0x20) | (Datain & 0x02) << 3;
+			// i = 0 Datain =  00,10,9,0021 // i = 1 Datain  = 00,12,11,0043
+			// i = 2 Datain =  00 ,14,13,0065 // i = 3 Datain =  00,16,15,0087
+			// key_value =  16,15,14,13,12,11,10,9,8,7,6,5,4,3,2,1.
+			key_value |= ((Datain & 0x000F) << (2 * i)) | (((Datain & 0x00F0) << 4) << (2 * i));
+		}
+		return key_value;
+	}
+};
+
+#endif
@@ -0,0 +1,386 @@
+/*!
+	@file     tm1638plus_fast.hpp
+	@author   Gavin Lyons
+	@brief    Header only TM1638 PICO driver with the GPIO pins and model fixed at compile time.
+	@details  TM1638plus_fast<STB, CLK, DIO, Model> is an alternative to the TM1638plus_model1/2/3
+		classes for code where the pins are known at build time. The bit loop writes the SIO
+		set / clear registers through constant masks, CLK low and the next DIO bit are driven
+		in one masked store, and model differences are resolved with if constexpr / requires,
+		there is no vtable. Bit-banged GPIO only, no PIO transport, bus group or key scanner,
+		use the model classes for those.
+*/
+
+#ifndef TM1638PLUS_FAST_H
+#define TM1638PLUS_FAST_H
+
+#include <cstdio>
+#include <cstring>
+#include "pico/stdlib.h"
+#include "hardware/structs/sio.h"
+#include "tm1638plus_core.hpp"
+#include "bus_timing.hpp"
+
+/*! TM1638 module types for TM1638plus_fast */
+enum class TM1638Model : uint8_t
+{
+	Model1 = 1, /**< 8 digits, 8 LEDs, 8 push buttons */
+	Model2 = 2, /**< 8 digits addressed by segment, 16 push buttons */
+	Model3 = 3  /**< 8 digits, 8 bi-color LEDs, 8 push buttons */
+};
+
+/*!
+	@brief TM1638 driver with compile time pins and model
+	@tparam STB GPIO STB pin
+	@tparam CLK GPIO CLK pin
+	@tparam DIO GPIO DIO pin
+	@tparam MODEL module type
+	@details Shares the shadow display RAM, flush cost model, text rendering and key
+		decoding of the model classes through TM1638plus_core, only the transport differs.
+		Methods not available on a model are removed at compile time.
+*/
+template <uint8_t STB, uint8_t CLK, uint8_t DIO, TM1638Model MODEL>
+class TM1638plus_fast : public TM1638plus_core
+{
+	static_assert(STB < 30 && CLK < 30 && DIO < 30, "TM1638plus_fast: pins must be GPIO 0-29");
+	static_assert(STB != CLK && STB != DIO && CLK != DIO, "TM1638plus_fast: pins must differ");
+
+public:
+	/*!
+		@brief Constructor
+		@param swapNibbles model 2 only, swap the nibbles of the digit data, default false
+	*/
+	TM1638plus_fast(bool swapNibbles = false) : _swapNibbles(swapNibbles) {}
+
+	/*!
+		@brief Begin method , sets pin modes and activate display.
+	*/
+	void displayBegin(void)
+	{
+		gpio_init_mask(PIN_MASK);
+		sio_hw->gpio_set = STB_MASK;
+		sio_hw->gpio_clr = CLK_MASK | DIO_MASK;
+		sio_hw->gpio_oe_set = PIN_MASK;
+		_totalBusBytes = 0;
+		sendCommand(TM_ACTIVATE);
+		brightness(TM_DEFAULT_BRIGHTNESS);
+		reset();
+	}
+
+	/*!
+		@brief Close method , clears display, deinits pin modes.
+	*/
+	void displayClose(void)
+	{
+		reset();
+		busy_wait_ms(50);
+		sio_hw->gpio_clr = PIN_MASK;
+		busy_wait_ms(50);
+		gpio_deinit(STB);
+		gpio_deinit(CLK);
+		gpio_deinit(DIO);
+	}
+
+	/*!
+		@brief Reset / clear the display and the shadow display RAM
+	*/
+	void reset(void)
+	{
+		memset(_displayRAM, 0, sizeof(_displayRAM));
+		flush(true);
+	}
+
+	/*!
+		@brief Sets the brightness level of segments in display
+		@param brightness 0 to 7 , default 2
+	*/
+	void brightness(uint8_t brightness)
+	{
+		sendCommand(TM_BRIGHT_ADR + (TM_BRIGHT_MASK & brightness));
+	}
+
+	/*!
+		@brief Set deferred mode for display writes
+		@param deferred true , writes only update the shadow display RAM until flush()
+	*/
+	void setDeferredMode(bool deferred) { _deferredMode = deferred; }
+
+	/*!
+		@brief Get deferred mode for display writes
+		@return true deferred mode on
+	*/
+	bool getDeferredMode(void) const { return _deferredMode; }
+
+	/*!
+		@brief Get number of bus bytes emitted by all flushes since displayBegin
+		@return bytes, commands + addresses + data
+	*/
+	uint32_t getTotalBusBytes(void) const { return _totalBusBytes; }
+
+	/*!
+		@brief Set the half bit delay of the bus
+		@param delayNs delay in nanoseconds, default 500nS
+	*/
+	void setBusDelayNs(uint32_t delayNs) { _busDelay.setDelayNs(delayNs); }
+
+	/*!
+		@brief Write the changed part of the shadow display RAM to the display
+		@param fullImage default false, if true all 16 addresses are rewritten.
+		@return Number of bytes put on the bus, 0 if nothing changed.
+		@note Cost model of TM1638plus_core::flushDirty, as TM1638plus_common::flush
+	*/
+	uint8_t flush(bool fullImage = false)
+	{
+		if (fullImage == true) _dirtyMask = 0xFFFF;
+		return flushDirty([this](const uint8_t *frame, uint8_t length) { sendFrame(frame, length); });
+	}
+
+	// Model 1 & 3 methods
+
+	/*!
+		@brief Set one LED, model 1 & 3
+		@param position 0-7 == L1-L8 on PCB
+		@param value model 1 : 0 off 1 on , model 3 : TMLEDColors
+	*/
+	void setLED(uint8_t position, uint8_t value) requires (MODEL != TM1638Model::Model2)
+	{
+		writeDisplayRAM((TM_LEDS_ADR - TM_SEG_ADR) + (position << 1), value);
+	}
+
+	/*!
+		@brief Set all LEDs in one transaction, model 1 & 3
+		@param ledvalues model 1 : 0x00LL , model 3 : 0xGGRR , LL/RR/GG bits 0-7 = L1-L8
+	*/
+	void setLEDs(uint16_t ledvalues) requires (MODEL != TM1638Model::Model2)
+	{
+		bool deferred = _deferredMode;
+		_deferredMode = true;
+		for (uint8_t LEDposition = 0; LEDposition < 8; LEDposition++)
+		{
+			uint8_t colour = 0;
+			if constexpr (MODEL == TM1638Model::Model3)
+			{
+				if (ledvalues & (1 << LEDposition)) colour |= TM_RED_LED;
+				if (ledvalues & (1 << (LEDposition + 8))) colour |= TM_GREEN_LED;
+			} else
+			{
+				if (ledvalues & (1 << LEDposition)) colour = 0x01;
+			}
+			setLED(LEDposition, colour);
+		}
+		_deferredMode = deferred;
+		if (_deferredMode == false) flush();
+	}
+
+	/*!
+		@brief Send seven segment value to a digit, model 1 & 3
+		@param position The position on display 0-7
+		@param value byte of data corresponding to segments (dp)gfedcba
+	*/
+	void display7Seg(uint8_t position, uint8_t value) requires (MODEL != TM1638Model::Model2)
+	{
+		writeDisplayRAM(position << 1, value);
+	}
+
+	/*!
+		@brief Display an ASCII character, model 1 & 3
+		@param position The position on display 0-7
+		@param ascii The ASCII value from font table to display
+		@param decimalPoint decimal point or off on the digit.
+	*/
+	void displayASCII(uint8_t position, uint8_t ascii, DecimalPoint_e decimalPoint = DecPointOff)
+		requires (MODEL != TM1638Model::Model2)
+	{
+		display7Seg(position, digitSegments(ascii, decimalPoint));
+	}
+
+	/*!
+		@brief Display a text string in one transaction, model 1 & 3
+		@param text pointer to a character array, "abc.def" lights the dot of c
+		@return Zero for success , -2 for null pointer
+	*/
+	int displayText(const char *text) requires (MODEL != TM1638Model::Model2)
+	{
+		if (text == nullptr)
+		{
+			printf("Error: displayText 1: String is a null pointer.\n");
+			return -2;
+		}
+		uint8_t values[TM_DISPLAY_SIZE];
+		uint8_t count = textToDigits(text, values);
+		bool deferred = _deferredMode;
+		_deferredMode = true;
+		for (uint8_t pos = 0; pos < count; pos++)
+		{
+			display7Seg(pos, values[pos]);
+		}
+		_deferredMode = deferred;
+		if (_deferredMode == false) flush();
+		return 0;
+	}
+
+	/*!
+		@brief Read buttons, model 1 & 3
+		@return buttons 1-8 in bits 0-7, 1 pressed
+	*/
+	uint8_t readButtons(void) requires (MODEL != TM1638Model::Model2)
+	{
+		uint8_t keyScan[4];
+		readFrame(keyScan, sizeof(keyScan));
+		return decodeButtons(keyScan);
+	}
+
+	// Model 2 methods
+
+	/*!
+		@brief Send one segment for all eight digits, model 2
+		@param segment 0-7 segments abcdefg(dp)
+		@param digit one bit per digit d8d7d6d5d4d3d2d1
+	*/
+	void DisplaySegments(uint8_t segment, uint8_t digit) requires (MODEL == TM1638Model::Model2)
+	{
+		if (_swapNibbles == true) digit = (uint8_t)((digit << 4) | (digit >> 4));
+		writeDisplayRAM(segment << 1, digit);
+	}
+
+	/*!
+		@brief Display a string in one transaction, model 2
+		@param string pointer to a character array, up to 8 characters
+		@param dots decimal points, bit 7 = first digit
+		@return Zero for success , -2 for null pointer, -4 character outside font range
+	*/
+	int DisplayStr(const char *string, uint16_t dots = 0) requires (MODEL == TM1638Model::Model2)
+	{
+		if (string == nullptr)
+		{
+			printf("Error: DisplayStr 1: String is a null pointer.\n");
+			return -2;
+		}
+		uint8_t values[TM_DISPLAY_SIZE];
+		int result = stringToDigits(string, dots, values);
+		if (result != 0) return result;
+		uint64_t matrix = digitsToSegments(values, _swapNibbles);
+		bool deferred = _deferredMode;
+		_deferredMode = true;
+		for (uint8_t segment = 0; segment < TM_DISPLAY_SIZE; segment++)
+		{
+			writeDisplayRAM(segment << 1, (uint8_t)(matrix >> (8 * segment)));
+		}
+		_deferredMode = deferred;
+		if (_deferredMode == false) flush();
+		return 0;
+	}
+
+	/*!
+		@brief Read push buttons, model 2
+		@return buttons S1-S16 in bits 0-15, 1 pressed
+	*/
+	uint16_t ReadKey16Two(void) requires (MODEL == TM1638Model::Model2)
+	{
+		uint8_t keyScan[4];
+		readFrame(keyScan, sizeof(keyScan));
+		return decodeKeys16(keyScan);
+	}
+
+private:
+	static constexpr uint32_t STB_MASK = 1u << STB; /**< SIO mask of STB */
+	static constexpr uint32_t CLK_MASK = 1u << CLK; /**< SIO mask of CLK */
+	static constexpr uint32_t DIO_MASK = 1u << DIO; /**< SIO mask of DIO */
+	static constexpr uint32_t PIN_MASK = STB_MASK | CLK_MASK | DIO_MASK; /**< SIO mask of all three pins */
+
+	BusTiming _busDelay{TM_HALF_BIT_NS}; /**< Half bit delay */
+	bool _swapNibbles = false;           /**< Model 2 nibble swap */
+
+	/*!
+		@brief Update one byte of the shadow display RAM, flushed at once unless deferred
+		@param address display RAM offset 0x00-0x0F
+		@param value data byte
+	*/
+	void writeDisplayRAM(uint8_t address, uint8_t value)
+	{
+		if (storeDisplayRAM(address, value) == true) flush();
+	}
+
+	/*!
+		@brief Shift a byte out LSB first
+		@param value byte to send
+		@note CLK low and the data bit go out in one masked store,
+			the TM1638 latches DIO on the rising edge of CLK.
+	*/
+	inline void shiftOut(uint8_t value)
+	{
+		for (uint8_t i = 0; i < 8; i++)
+		{
+			gpio_put_masked(CLK_MASK | DIO_MASK, (value & 0x01) ? DIO_MASK : 0);
+			value >>= 1;
+			_busDelay.wait();
+			sio_hw->gpio_set = CLK_MASK;
+			_busDelay.wait();
+		}
+		sio_hw->gpio_clr = CLK_MASK;
+	}
+
+	/*!
+		@brief Shift a byte in LSB first, DIO must be an input
+		@return byte read
+	*/
+	inline uint8_t shiftIn(void)
+	{
+		uint8_t value = 0;
+		for (uint8_t i = 0; i < 8; i++)
+		{
+			sio_hw->gpio_set = CLK_MASK;
+			_busDelay.wait();
+			value |= ((sio_hw->gpio_in >> DIO) & 0x01) << i;
+			sio_hw->gpio_clr = CLK_MASK;
+			_busDelay.wait();
+		}
+		return value;
+	}
+
+	/*!
+		@brief Send a frame of bytes, STB is held low for the whole frame.
+		@param data pointer to the bytes to send
+		@param length number of bytes in frame
+	*/
+	void sendFrame(const uint8_t *data, uint8_t length)
+	{
+		_busDelay.update();
+		sio_hw->gpio_clr = STB_MASK;
+		for (uint8_t i = 0; i < length; i++)
+		{
+			shiftOut(data[i]);
+		}
+		sio_hw->gpio_set = STB_MASK;
+	}
+
+	/*!
+		@brief Send a one byte command frame
+		@param value command byte
+	*/
+	void sendCommand(uint8_t value)
+	{
+		sendFrame(&value, 1);
+	}
+
+	/*!
+		@brief Send the read key scan command and read back the key scan bytes.
+		@param data buffer for the key scan bytes
+		@param length number of bytes to read 1-4
+	*/
+	void readFrame(uint8_t *data, uint8_t length)
+	{
+		_busDelay.update();
+		sio_hw->gpio_clr = STB_MASK;
+		shiftOut(TM_BUTTONS_MODE);
+		busy_wait_us(TM_READ_WAIT_US); // Twait, a 1uS wait can end early by up to one timer tick
+		sio_hw->gpio_oe_clr = DIO_MASK;
+		for (uint8_t i = 0; i < length; i++)
+		{
+			data[i] = shiftIn();
+		}
+		sio_hw->gpio_oe_set = DIO_MASK;
+		sio_hw->gpio_set = STB_MASK;
+	}
+};
+
+#endif
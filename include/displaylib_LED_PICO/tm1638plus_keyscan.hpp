@@ -0,0 +1,37 @@
+/*!
+	@file     tm1638plus_keyscan.hpp
+	@author   Gavin Lyons
+	@brief    PICO library Header file, background key scanner for TM1638 modules.
+*/
+
+#ifndef TM1638PLUS_KEYSCAN_H
+#define TM1638PLUS_KEYSCAN_H
+
+#include "pico/stdlib.h"
+#include "key_scanner.hpp"
+#include "tm1638plus_common.hpp"
+
+/*!
+	@brief Background key scanner for TM1638 models 1, 2 and 3.
+	@details Key numbers are the bits of readButtons() (models 1 & 3, keys 0-7)
+		or ReadKey16Two() (model 2, keys 0-15). A sample that falls while the
+		display is being written is deferred and taken as soon as the write ends,
+		so scanning and display flushes never share the bus mid-frame.
+*/
+class TM1638plus_keyscan : public KeyScanner
+{
+
+public:
+	TM1638plus_keyscan(TM1638plus_common &module);
+	~TM1638plus_keyscan();
+
+protected:
+	bool readKeys(uint16_t &keys) override;
+
+private:
+	TM1638plus_common *_module; /**< Module being scanned */
+
+	static void deferredScan(void *context);
+};
+
+#endif
@@ -19,7 +19,7 @@ class TM1638plus_model1 : public TM1638plus_common  {
 
 public:
 	// Constructor 
-	TM1638plus_model1(uint8_t strobe, uint8_t clock, uint8_t data);
+	TM1638plus_model1(uint8_t strobe, uint8_t clock, uint8_t data, PIO pio = nullptr);
 	
 	// Methods
 	uint8_t readButtons(void);
@@ -33,6 +33,9 @@ public:
 	void display7Seg(uint8_t position, uint8_t value);
 	void displayIntNum(unsigned long number, TextAlignment_e = AlignLeft);
 	void DisplayDecNumNibble(uint16_t numberUpper, uint16_t numberLower, TextAlignment_e = AlignLeft);
+
+protected:
+	uint16_t readKeyMatrix(void) override;
 };
 
 #endif
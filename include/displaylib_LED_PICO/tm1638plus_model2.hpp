@@ -11,6 +11,7 @@
 #include <cstdio>
 #include <cstring>
 #include "tm1638plus_common.hpp"
+#include "bit_matrix.hpp"
 
 /*!
 	@brief Class for Model 2
@@ -20,7 +21,7 @@ class TM1638plus_model2 : public TM1638plus_common
 
 public:
 	// Constructor Init the module
-	TM1638plus_model2(uint8_t strobe, uint8_t clock, uint8_t data, bool swap_nibbles);
+	TM1638plus_model2(uint8_t strobe, uint8_t clock, uint8_t data, bool swap_nibbles, PIO pio = nullptr);
 
 	// Methods
 	uint8_t ReadKey16(void);
@@ -33,6 +34,9 @@ public:
 	void ASCIItoSegment(const uint8_t values[]);
 	void DisplayDecNumNibble(uint16_t numberUpper, uint16_t numberLower, uint8_t dots, TextAlignment_e = AlignLeft);
 
+protected:
+	uint16_t readKeyMatrix(void) override;
+
 private:
 	bool _SWAP_NIBBLES = false; /**< If true the nibbles in display byte will be switched AAAABBBB BBBBAAAA */
 };
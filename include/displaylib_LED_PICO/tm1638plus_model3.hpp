@@ -18,20 +18,22 @@
 class TM1638plus_model3 : public TM1638plus_model1   {
 
 public:
-	/*! Tm1638 bi-color LED colors */
-	enum TMLEDColors : uint8_t
-	{
-		TM_RED_LED = 0x02,   /**< Turn on Red LED*/
-		TM_GREEN_LED = 0x01, /**< Turn on Green LED*/
-		TM_OFF_LED = 0x00    /**< Turn off  LED*/
-	};
+	/*! Packed bi-color LED frame, 2 bits per LED holding a TMLEDColors value, L1 in bits 1-0 to L8 in bits 15-14 */
+	typedef uint16_t LEDFrame_t;
 
 	// Constructor 
-	TM1638plus_model3 (uint8_t strobe, uint8_t clock, uint8_t data) ;
+	TM1638plus_model3 (uint8_t strobe, uint8_t clock, uint8_t data, PIO pio = nullptr) ;
 	
 	// These methods over-ride the super class.
 	virtual void setLEDs(uint16_t greenred) override;
 	virtual void setLED(uint8_t position, uint8_t value) override;
+
+	// LED frame methods, written in one burst with the segment data
+	void setLEDFrame(LEDFrame_t frame);
+	LEDFrame_t getLEDFrame(void) const;
+	void fillLEDs(TMLEDColors colour);
+	void setLEDRange(uint8_t start, uint8_t count, TMLEDColors colour);
+	void rotateLEDs(int8_t steps);
 };
 
 #endif
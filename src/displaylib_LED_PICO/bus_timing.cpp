@@ -0,0 +1,67 @@
+/*!
+	@file   bus_timing.cpp
+	@author Gavin Lyons
+	@brief  Sub-microsecond delay used by the bit-banged serial buses of the LED modules.
+*/
+
+#include "hardware/clocks.h"
+#include "../../include/displaylib_LED_PICO/bus_timing.hpp"
+
+/*!
+	@brief Constructor for class BusTiming
+	@param delayNs delay in nanoseconds
+	@note The cycle count is computed on the next update() call,
+		as the clocks may not be set up yet when global objects are constructed.
+*/
+BusTiming::BusTiming(uint32_t delayNs)
+{
+	_delayNs = delayNs;
+}
+
+/*!
+	@brief Set the delay
+	@param delayNs delay in nanoseconds
+	@note Takes effect at the next update() call.
+*/
+void BusTiming::setDelayNs(uint32_t delayNs)
+{
+	_delayNs = delayNs;
+	_sysHz = 0; // force recompute
+}
+
+/*!
+	@brief Get the delay
+	@return delay in nanoseconds
+*/
+uint32_t BusTiming::getDelayNs(void) const
+{
+	return _delayNs;
+}
+
+/*!
+	@brief Get the delay
+	@return delay in clk_sys cycles, as computed at the last update
+*/
+uint32_t BusTiming::getDelayCycles(void) const
+{
+	return _cycles;
+}
+
+/*!
+	@brief Recompute the cycle count if the system clock frequency has changed
+*/
+void BusTiming::update(void)
+{
+	uint32_t sysHz = clock_get_hz(clk_sys);
+	if (sysHz != _sysHz) recompute(sysHz);
+}
+
+/*!
+	@brief Convert the delay to cycles, rounded up so the delay is never shorter than set
+	@param sysHz clk_sys frequency in hertz
+*/
+void BusTiming::recompute(uint32_t sysHz)
+{
+	_sysHz = sysHz;
+	_cycles = (uint32_t)(((uint64_t)_delayNs * sysHz + 999999999ULL) / 1000000000ULL);
+}
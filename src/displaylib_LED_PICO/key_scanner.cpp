@@ -0,0 +1,230 @@
+/*!
+	@file   key_scanner.cpp
+	@author Gavin Lyons
+	@brief  Background key scanner with debounce and event queue, for LED modules with a key matrix.
+*/
+
+#include "hardware/sync.h"
+#include "../../include/displaylib_LED_PICO/key_scanner.hpp"
+
+/*!
+	@brief Constructor for class KeyScanner
+*/
+KeyScanner::KeyScanner()
+{
+	// Blank constructor
+}
+
+/*!
+	@brief Destructor for class KeyScanner, stops the timer
+*/
+KeyScanner::~KeyScanner()
+{
+	scanEnd();
+}
+
+/*!
+	@brief Start sampling the keys from a repeating timer
+	@param periodMs sample period in milliseconds, e.g 10
+	@return true success, false no timer slot available or already scanning
+	@note The timer callback runs in interrupt context on the calling core.
+		If the sub-class reads the keys outside the interrupt, call poll() from the main loop.
+*/
+bool KeyScanner::scanBegin(uint32_t periodMs)
+{
+	if (_scanning == true || periodMs == 0) return false;
+	_scanning = true;
+	// negative delay = period measured between callback starts
+	if (!add_repeating_timer_ms(-(int32_t)periodMs, timerCallback, this, &_timer))
+	{
+		_scanning = false;
+		return false;
+	}
+	return true;
+}
+
+/*!
+	@brief Stop sampling the keys
+*/
+void KeyScanner::scanEnd(void)
+{
+	if (_scanning == false) return;
+	_scanning = false;
+	cancel_repeating_timer(&_timer);
+}
+
+/*!
+	@brief Is the timer driven scan running
+	@return true scanning
+*/
+bool KeyScanner::isScanning(void) const
+{
+	return _scanning;
+}
+
+/*!
+	@brief Take one sample of the keys, debounce and queue events
+	@note Called from the timer, or by the application in polled mode.
+		If the bus is busy with a display transfer the sample is deferred
+		by the sub-class until the transfer is complete.
+*/
+void KeyScanner::scanTick(void)
+{
+	if (_inTick == true) return; // timer fired while a deferred sample runs
+	_inTick = true;
+	uint16_t raw = 0;
+	if (!readKeys(raw))
+	{
+		_inTick = false;
+		return;
+	}
+	for (uint8_t key = 0; key < KEY_COUNT; key++)
+	{
+		uint16_t mask = (1 << key);
+		if (raw & mask)
+		{
+			if (_integrator[key] < _debounceSamples) _integrator[key]++;
+		} else
+		{
+			if (_integrator[key] > 0) _integrator[key]--;
+		}
+
+		if (!(_keyState & mask) && _integrator[key] >= _debounceSamples)
+		{
+			_keyState |= mask;
+			_heldSamples[key] = 0;
+			_longPressSent &= ~mask;
+			pushEvent(key, KeyPress);
+		} else if ((_keyState & mask) && _integrator[key] == 0)
+		{
+			_keyState &= ~mask;
+			pushEvent(key, KeyRelease);
+		} else if (_keyState & mask)
+		{
+			if (_heldSamples[key] < UINT16_MAX) _heldSamples[key]++;
+			if (_longPressSamples != 0 && !(_longPressSent & mask) && _heldSamples[key] >= _longPressSamples)
+			{
+				_longPressSent |= mask;
+				pushEvent(key, KeyLongPress);
+			}
+		}
+	}
+	_inTick = false;
+}
+
+/*!
+	@brief Take the sample marked due by the timer, for sub-classes that read the keys
+		outside the interrupt. Call from the main loop at least once per scan period.
+	@note Does nothing if no sample is due, or if the timer reads the keys itself.
+*/
+void KeyScanner::poll(void)
+{
+	if (_samplePending == false) return;
+	_samplePending = false;
+	scanTick();
+}
+
+/*!
+	@brief A sample is due, take it now or leave it for poll()
+	@note Called from the timer and from the sub-class when a deferred sample can be taken.
+*/
+void KeyScanner::sampleDue(void)
+{
+	if (_readInInterrupt == true)
+		scanTick();
+	else
+		_samplePending = true;
+}
+
+/*!
+	@brief Get the next key event, does not block
+	@param event filled with the event
+	@return true event returned, false queue empty
+*/
+bool KeyScanner::getEvent(KeyEvent_t &event)
+{
+	uint8_t tail = _tail;
+	if (tail == _head) return false;
+	__dmb(); // read the slot after seeing the producer's head update
+	event = _queue[tail];
+	__dmb();
+	_tail = (tail + 1) & (EVENT_QUEUE_SIZE - 1);
+	return true;
+}
+
+/*!
+	@brief Get number of events waiting in the queue
+	@return number of events
+*/
+uint8_t KeyScanner::getEventCount(void) const
+{
+	return (_head - _tail) & (EVENT_QUEUE_SIZE - 1);
+}
+
+/*!
+	@brief Get the debounced state of all keys
+	@return one bit per key, 1 = pressed
+*/
+uint16_t KeyScanner::getKeyState(void) const
+{
+	return _keyState;
+}
+
+/*!
+	@brief Get number of events lost because the application did not drain the queue
+	@return number of dropped events
+*/
+uint16_t KeyScanner::getOverflowCount(void) const
+{
+	return _overflowCount;
+}
+
+/*!
+	@brief Set the debounce time
+	@param samples number of consecutive samples for a key to change state 1-255, default 3
+*/
+void KeyScanner::setDebounce(uint8_t samples)
+{
+	_debounceSamples = (samples == 0) ? 1 : samples;
+}
+
+/*!
+	@brief Set the long press time
+	@param samples number of samples a key must be held for a long press event, default 100, 0 = off
+*/
+void KeyScanner::setLongPress(uint16_t samples)
+{
+	_longPressSamples = samples;
+}
+
+/*!
+	@brief Put an event in the ring buffer, producer side
+	@param key key number 0-15
+	@param type type of event
+*/
+void KeyScanner::pushEvent(uint8_t key, KeyEventType_e type)
+{
+	uint8_t head = _head;
+	uint8_t next = (head + 1) & (EVENT_QUEUE_SIZE - 1);
+	if (next == _tail)
+	{
+		_overflowCount++;
+		return;
+	}
+	_queue[head].key = key;
+	_queue[head].type = type;
+	__dmb(); // slot written before the consumer can see it
+	_head = next;
+}
+
+/*!
+	@brief Repeating timer callback
+	@param rt repeating timer, user_data holds the scanner
+	@return true to keep the timer running
+*/
+bool KeyScanner::timerCallback(repeating_timer_t *rt)
+{
+	KeyScanner *scanner = static_cast<KeyScanner *>(rt->user_data);
+	scanner->sampleDue();
+	return scanner->_scanning;
+}
@@ -4,6 +4,13 @@
 	@brief  library source file to drive MAX7219 displays
 */
 #include "../../include/displaylib_LED_PICO/max7219.hpp"
+#include "hardware/clocks.h"
+#include "max7219.pio.h"
+
+MAX7219plus_model5 *MAX7219plus_model5::_DMAOwner[NUM_DMA_CHANNELS] = {nullptr};
+bool MAX7219plus_model5::_DMAIRQInstalled = false;
+int8_t MAX7219plus_model5::_pioProgramOffset[2] = {-1, -1};
+uint8_t MAX7219plus_model5::_pioProgramUsers[2] = {0, 0};
 
 // Public methods
 
@@ -21,6 +28,7 @@ MAX7219plus_model5::MAX7219plus_model5(uint8_t clock, uint8_t chipSelect , uint8
 	_Display_CS  = chipSelect;
 	_Display_SDATA = data;
 	_CommDelay = CommDelay;
+	_CommTiming.setDelayNs((uint32_t)CommDelay * 1000);
 	_HardwareSPI = false;
 }
 
@@ -43,11 +51,50 @@ MAX7219plus_model5::MAX7219plus_model5(uint8_t clock, uint8_t chipSelect , uint8
 	_HardwareSPI = true;
 }
 
+/*!
+	@brief Constructor for class MAX7219plus_model5 PIO SPI
+	@param clock CLk pin
+	@param chipSelect CS pin
+	@param data DIO pin
+	@param baudrate baudrate in Khz , 1000 = 1 Mhz , maximum MAX7219_PIO_MAX_KHZ
+	@param pio PIO instance, pio0 or pio1
+	@note overloaded this one is for a PIO SPI transmitter on any GPIO, the PIO drives CS
+		for each frame. If no state machine is free at init, software SPI is used.
+*/
+MAX7219plus_model5::MAX7219plus_model5(uint8_t clock, uint8_t chipSelect , uint8_t data, uint32_t baudrate, PIO pio)
+{
+	if (baudrate == 0) baudrate = 1;
+	if (baudrate > MAX7219_PIO_MAX_KHZ)
+	{
+		printf("Error: MAX7219plus_model5 1: PIO SPI baudrate maximum is %lu kHz.\n", (unsigned long)MAX7219_PIO_MAX_KHZ);
+		baudrate = MAX7219_PIO_MAX_KHZ;
+	}
+	_Display_SCLK = clock;
+	_Display_CS  = chipSelect;
+	_Display_SDATA = data;
+	_speedSPIKHz = baudrate;
+	_pio = pio;
+	_CommTiming.setDelayNs(500000 / baudrate); // software SPI fallback, half clock period
+	_HardwareSPI = false;
+}
+
 /*!
 	@brief End display operations, called at end of program
 */
 void MAX7219plus_model5::DisplayEndOperations(void)
 {
+	StopScrubber();
+	StopFade();
+	WaitFlush();
+	FlushReleaseDMA();
+	if (_pio != nullptr)
+	{
+		PIOClose();
+		gpio_deinit(_Display_CS);
+		gpio_deinit(_Display_SCLK);
+		gpio_deinit(_Display_SDATA);
+		return;
+	}
 	gpio_put(_Display_CS, false);
 	gpio_deinit(_Display_CS);
 	if (_HardwareSPI == true) {
@@ -71,6 +118,13 @@ void MAX7219plus_model5::DisplayEndOperations(void)
 bool MAX7219plus_model5::GetHardwareSPI(void)
 {return _HardwareSPI;}
 
+/*!
+	@brief get PIO SPI status
+	@return true PIO SPI transmitter in use, false hardware or software SPI
+*/
+bool MAX7219plus_model5::GetPIOSPI(void)
+{return _pio != nullptr;}
+
 
 /*!
 	@brief Init the display
@@ -82,29 +136,7 @@ void MAX7219plus_model5::InitDisplay(ScanLimit_e numDigits, DecodeMode_e decodeM
 {
 	if (_CurrentDisplayNumber == 1)
 	{
-		gpio_init(_Display_SDATA);
-		gpio_init(_Display_SCLK);
-		gpio_init(_Display_CS);
-		gpio_set_dir(_Display_CS, GPIO_OUT);
-		if (_HardwareSPI == false)
-		{
-			gpio_set_dir(_Display_SCLK, GPIO_OUT);
-			gpio_set_dir(_Display_SDATA, GPIO_OUT);
-			gpio_put(_Display_CS, true);
-		}else
-		{
-			spi_init(_pspiInterface, _speedSPIKHz * 1000); // Initialize SPI port 
-			// Initialize SPI pins : clock and data
-			gpio_set_function(_Display_SCLK, GPIO_FUNC_SPI);
-			gpio_set_function(_Display_SDATA, GPIO_FUNC_SPI);
-			// Set SPI format
-			spi_set_format( _pspiInterface,   // SPI instance
-							8,      // Number of bits per transfer
-							SPI_CPOL_0,      // Polarity (CPOL)
-							SPI_CPHA_0,      // Phase (CPHA)
-							SPI_MSB_FIRST);
-			busy_wait_ms(50); // small init delay before commencing transmissions
-		}
+		InitBus();
 	}
 
 	_NoDigits = numDigits+1;
@@ -118,6 +150,42 @@ void MAX7219plus_model5::InitDisplay(ScanLimit_e numDigits, DecodeMode_e decodeM
 	SetBrightness(IntensityDefault);
 }
 
+/*!
+	@brief Set up the GPIO and SPI interface, called by InitDisplay and InitDisplayAll
+*/
+void MAX7219plus_model5::InitBus(void)
+{
+	if (_pio != nullptr)
+	{
+		if (_pioSM >= 0 || PIOBegin() == true) return;
+		printf("Error: InitBus 1: PIO transport unavailable, using software SPI.\n");
+		_pio = nullptr;
+	}
+	gpio_init(_Display_SDATA);
+	gpio_init(_Display_SCLK);
+	gpio_init(_Display_CS);
+	gpio_set_dir(_Display_CS, GPIO_OUT);
+	if (_HardwareSPI == false)
+	{
+		gpio_set_dir(_Display_SCLK, GPIO_OUT);
+		gpio_set_dir(_Display_SDATA, GPIO_OUT);
+		gpio_put(_Display_CS, true);
+	}else
+	{
+		spi_init(_pspiInterface, _speedSPIKHz * 1000); // Initialize SPI port 
+		// Initialize SPI pins : clock and data
+		gpio_set_function(_Display_SCLK, GPIO_FUNC_SPI);
+		gpio_set_function(_Display_SDATA, GPIO_FUNC_SPI);
+		// Set SPI format, one register/data pair per transfer
+		spi_set_format( _pspiInterface,   // SPI instance
+						16,     // Number of bits per transfer
+						SPI_CPOL_0,      // Polarity (CPOL)
+						SPI_CPHA_0,      // Phase (CPHA)
+						SPI_MSB_FIRST);
+		busy_wait_ms(50); // small init delay before commencing transmissions
+	}
+}
+
 /*!
 	@brief Clear the display
 */
@@ -369,7 +437,28 @@ void MAX7219plus_model5:: DisplayTestMode(bool OnOff)
 	@brief Set the communication delay value
 	@param commDelay Set the communication delay value uS software SPI
 */
-void MAX7219plus_model5::SetCommDelay(uint16_t commDelay) {_CommDelay = commDelay;}
+void MAX7219plus_model5::SetCommDelay(uint16_t commDelay)
+{
+	_CommDelay = commDelay;
+	_CommTiming.setDelayNs((uint32_t)commDelay * 1000);
+}
+
+/*!
+	@brief Set the communication delay value in nanoseconds
+	@param commDelayNs communication delay nS software SPI, half clock period.
+	@note MAX7219 minimum clock pulse width is 50nS.
+*/
+void MAX7219plus_model5::SetCommDelayNs(uint32_t commDelayNs)
+{
+	_CommDelay = commDelayNs / 1000;
+	_CommTiming.setDelayNs(commDelayNs);
+}
+
+/*!
+	@brief Get the communication delay value in nanoseconds
+	@return communication delay nS software SPI
+*/
+uint32_t MAX7219plus_model5::GetCommDelayNs(void) const {return _CommTiming.getDelayNs();}
 
 /*!
 	@brief Get the communication delay value
@@ -381,17 +470,23 @@ uint16_t  MAX7219plus_model5::GetCommDelay(void) {return _CommDelay;}
 	@brief Get the Current Display Number
 	@return Get the Current Display Number
 */
-uint8_t MAX7219plus_model5::GetCurrentDisplayNumber(void){return _CurrentDisplayNumber; }
+uint16_t MAX7219plus_model5::GetCurrentDisplayNumber(void){return _CurrentDisplayNumber; }
 
 /*!
 	@brief Set the Current Display Number
 	@param DisplayNum Set the Current Display Number
 */
-void MAX7219plus_model5::SetCurrentDisplayNumber(uint8_t DisplayNum )
+void MAX7219plus_model5::SetCurrentDisplayNumber(uint16_t DisplayNum )
 {
 if (DisplayNum == 0 ) DisplayNum = 1; // Zero user error check
+if (DisplayNum > MAX7219_MAX_CHAIN)
+{
+	printf("Error: SetCurrentDisplayNumber 1: Display number maximum is %u.\n", MAX7219_MAX_CHAIN);
+	DisplayNum = MAX7219_MAX_CHAIN;
+}
 
 _CurrentDisplayNumber  = DisplayNum  ;
+if (DisplayNum > _HighestDisplay) _HighestDisplay = DisplayNum;
 }
 
 /*!
@@ -458,23 +553,476 @@ void MAX7219plus_model5::DisplayDecNumNibble(uint16_t  numberUpper, uint16_t num
 
 
 
+/*!
+	@brief Set the number of displays in the cascade
+	@param chainLength 1 to MAX7219_MAX_CHAIN , default 1
+	@note Every frame then covers the whole chain, so no display latches stale data.
+		Display 1 is the one nearest the PICO. MAX7219_MAX_CHAIN is set at build time,
+		define MAX7219_MAX_CHAIN_LENGTH for longer chains.
+*/
+void MAX7219plus_model5::SetChainLength(uint16_t chainLength)
+{
+	if (chainLength == 0) chainLength = 1;
+	if (chainLength > MAX7219_MAX_CHAIN)
+	{
+		printf("Error: SetChainLength 1: Chain length maximum is %u.\n", MAX7219_MAX_CHAIN);
+		chainLength = MAX7219_MAX_CHAIN;
+	}
+	_ChainLength = chainLength;
+}
+
+/*!
+	@brief Get the number of displays in the cascade
+	@return chain length
+*/
+uint16_t MAX7219plus_model5::GetChainLength(void) {return _ChainLength;}
+
+/*!
+	@brief Set deferred mode for digit register writes
+	@param deferred true , display methods only update the register shadow of the
+		current display, RefreshChain() writes all displays. false (default) written at once.
+	@note Control registers (brightness, shutdown, etc) are always written at once.
+*/
+void MAX7219plus_model5::SetDeferredMode(bool deferred) {_DeferredMode = deferred;}
+
+/*!
+	@brief Get deferred mode
+	@return true deferred mode on
+*/
+bool MAX7219plus_model5::GetDeferredMode(void) {return _DeferredMode;}
+
+/*!
+	@brief Init all displays in the cascade, each setting is one frame for the whole chain
+	@param numDigits scan limit set to 8 normally , advanced use only
+	@param decodeMode Must users will use 0x00 here
+	@note Set the chain length first.
+*/
+void MAX7219plus_model5::InitDisplayAll(ScanLimit_e numDigits, DecodeMode_e decodeMode)
+{
+	InitBus();
+	_NoDigits = numDigits+1;
+	CurrentDecodeMode = decodeMode;
+
+	BroadcastRegister(MAX7219_REG_ScanLimit, numDigits);
+	BroadcastRegister(MAX7219_REG_DecodeMode, decodeMode);
+	ShutdownModeAll(false);
+	DisplayTestModeAll(false);
+	ClearDisplayAll();
+	SetBrightnessAll(IntensityDefault);
+}
+
+/*!
+	@brief Clear all displays in the cascade, one frame per digit
+	@note BCD decoded digits are set to CodeBFontSpace, others to zero.
+*/
+void MAX7219plus_model5::ClearDisplayAll(void)
+{
+	for (uint8_t digit = 0; digit < _NoDigits; digit++)
+	{
+		bool decoded = (CurrentDecodeMode >> digit) & 0x01;
+		BroadcastRegister(digit + 1, decoded ? CodeBFontSpace : 0x00);
+	}
+}
+
+/*!
+	@brief Set the brightness of all displays in the cascade
+	@param brightness rang 0x00 to 0x0F , 0x00 being least bright.
+*/
+void MAX7219plus_model5::SetBrightnessAll(uint8_t brightness)
+{
+	BroadcastRegister(MAX7219_REG_Intensity, brightness & IntensityMax);
+}
+
+/*!
+	@brief Turn on and off the Shutdown Mode of all displays in the cascade
+	@param OnOff true = Shutdown mode on , false shutdown mode off
+*/
+void MAX7219plus_model5::ShutdownModeAll(bool OnOff)
+{
+	BroadcastRegister(MAX7219_REG_ShutDown, OnOff ? 0 : 1);
+}
+
+/*!
+	@brief Turn on and off the Display Test Mode of all displays in the cascade
+	@param OnOff true = display test mode on , false display Test Mode off
+*/
+void MAX7219plus_model5::DisplayTestModeAll(bool OnOff)
+{
+	BroadcastRegister(MAX7219_REG_DisplayTest, OnOff ? 1 : 0);
+}
+
+/*!
+	@brief Write the same register and data to every display in one frame
+	@param RegisterCode the register to write to
+	@param data The data byte to send to register
+	@note The frame covers FrameChips() displays, those past the chain length get a NOP.
+*/
+void MAX7219plus_model5::BroadcastRegister(uint8_t RegisterCode, uint8_t data)
+{
+	uint16_t chips = FrameChips();
+	for (uint16_t display = 1; display <= _ChainLength; display++)
+	{
+		_FrameBuffer[chips - display] = FrameWord(RegisterCode, data);
+		_RegisterShadow[display - 1][RegisterCode & 0x0F] = data;
+	}
+	SendFrame(_FrameBuffer, chips);
+	ClearFrame(chips);
+}
+
+/*!
+	@brief Write one register with different data on every display in one frame
+	@param RegisterCode the register to write to
+	@param data chain length bytes, data[0] for display 1
+	@note The frame covers FrameChips() displays, those past the chain length get a NOP.
+*/
+void MAX7219plus_model5::WriteAllDisplays(uint8_t RegisterCode, const uint8_t data[])
+{
+	uint16_t chips = FrameChips();
+	for (uint16_t display = 1; display <= _ChainLength; display++)
+	{
+		_FrameBuffer[chips - display] = FrameWord(RegisterCode, data[display - 1]);
+		_RegisterShadow[display - 1][RegisterCode & 0x0F] = data[display - 1];
+	}
+	SendFrame(_FrameBuffer, chips);
+	ClearFrame(chips);
+}
+
+/*!
+	@brief Write a different register and data on every display in one frame
+	@param RegisterCodes chain length register codes, [0] for display 1, MAX7219_REG_NOP to skip a display
+	@param data chain length bytes, data[0] for display 1
+	@note The frame covers FrameChips() displays, those past the chain length get a NOP.
+*/
+void MAX7219plus_model5::WriteCascade(const uint8_t RegisterCodes[], const uint8_t data[])
+{
+	uint16_t chips = FrameChips();
+	for (uint16_t display = 1; display <= _ChainLength; display++)
+	{
+		_FrameBuffer[chips - display] = FrameWord(RegisterCodes[display - 1], data[display - 1]);
+		if (RegisterCodes[display - 1] != MAX7219_REG_NOP)
+			_RegisterShadow[display - 1][RegisterCodes[display - 1] & 0x0F] = data[display - 1];
+	}
+	SendFrame(_FrameBuffer, chips);
+	ClearFrame(chips);
+}
+
+/*!
+	@brief Write the digit registers of every display from the register shadow
+	@note One frame per digit register, 8 frames for the whole chain with 8 digits.
+		Use with deferred mode to update all displays with SetCurrentDisplayNumber
+		and the display methods, then send them together.
+		Frames cover FrameChips() displays, every one from its shadow.
+*/
+void MAX7219plus_model5::RefreshChain(void)
+{
+	uint16_t chips = FrameChips();
+	for (uint8_t digit = 1; digit <= _NoDigits; digit++)
+	{
+		for (uint16_t display = 1; display <= chips; display++)
+		{
+			_FrameBuffer[chips - display] = FrameWord(digit, _RegisterShadow[display - 1][digit]);
+		}
+		SendFrame(_FrameBuffer, chips);
+	}
+	ClearFrame(chips);
+}
+
+/*!
+	@brief Write the digit registers of every display from the register shadow, without waiting
+	@return 0 success , -3 software SPI , -4 no free DMA channel
+	@note Same frames as RefreshChain, built into a double buffer and sent by DMA paced by the
+		SPI TX DREQ. CS is toggled between frames from the DMA IRQ.
+		If a flush is running the new one is queued and sent after it, a later call replaces
+		a queued flush not yet started. The shadow is copied, so the display methods can be used
+		at once. Synchronous writes wait for the flush to complete.
+*/
+int MAX7219plus_model5::FlushAsync(void)
+{
+	int spare = FlushPrepare();
+	if (spare < 0) return spare;
+
+	uint32_t status = save_and_disable_interrupts();
+	FlushCommit(spare, true);
+	restore_interrupts(status);
+	return 0;
+}
+
+/*!
+	@brief Is an asynchronous flush running or queued
+	@return true busy
+*/
+bool MAX7219plus_model5::IsFlushBusy(void) {return _FlushBusy;}
+
+/*!
+	@brief Wait until the asynchronous flush and any queued flush complete
+*/
+void MAX7219plus_model5::WaitFlush(void)
+{
+	while (_FlushBusy == true)
+	{
+		tight_loop_contents();
+	}
+}
+
+/*!
+	@brief Set the function called when an asynchronous flush completes
+	@param callback function, called from the DMA interrupt, nullptr for none
+	@param context argument passed to callback
+*/
+void MAX7219plus_model5::SetFlushCallback(void (*callback)(void *), void *context)
+{
+	uint32_t status = save_and_disable_interrupts();
+	_FlushCallback = callback;
+	_FlushCallbackContext = context;
+	restore_interrupts(status);
+}
+
+/*!
+	@brief Rewrite registers of every display from the register shadow, one frame per register
+	@param budget maximum number of registers to rewrite in this call
+	@return number of registers rewritten, 0 if the bus or the DMA flush is busy
+	@details Registers rewritten in a cycle : shutdown, scan limit, decode mode, intensity,
+		display test, then the digit registers. Frames cover the same displays as the
+		display methods, see FrameChips. Each call continues the cycle where the
+		last one stopped, so every register is rewritten within (5 + digits) / budget calls
+		without a large bus burst. Rewriting a register with its own value causes no flicker.
+	@note In deferred mode the digit registers are skipped, as the shadow may hold values
+		not yet sent, RefreshChain or FlushAsync rewrite them.
+*/
+uint8_t MAX7219plus_model5::ScrubRegisters(uint8_t budget)
+{
+	static constexpr uint8_t controlRegisters[5] = {MAX7219_REG_ShutDown, MAX7219_REG_ScanLimit,
+		MAX7219_REG_DecodeMode, MAX7219_REG_Intensity, MAX7219_REG_DisplayTest};
+	if (_BusActive == true || _FlushBusy == true) return 0;
+
+	uint16_t chips = FrameChips();
+	uint8_t total = 5 + (_DeferredMode ? 0 : _NoDigits);
+	uint8_t done = 0;
+	while (done < budget && done < total)
+	{
+		if (_ScrubIndex >= total) _ScrubIndex = 0;
+		uint8_t RegisterCode = (_ScrubIndex < 5) ? controlRegisters[_ScrubIndex] : (_ScrubIndex - 4);
+		for (uint16_t display = 1; display <= chips; display++)
+		{
+			_ScrubBuffer[chips - display] = FrameWord(RegisterCode, _RegisterShadow[display - 1][RegisterCode]);
+		}
+		SendFrame(_ScrubBuffer, chips);
+		_ScrubIndex++;
+		done++;
+	}
+	return done;
+}
+
+/*!
+	@brief Start the background register scrubber
+	@param periodMs timer period mS
+	@param budget registers rewritten per timer tick
+	@return 0 success , -3 no free timer
+	@note Calls ScrubRegisters from a repeating timer interrupt. A tick is skipped while
+		the display methods are writing or a DMA flush is running.
+		With software SPI a long chain makes the interrupt long, keep the budget small.
+*/
+int MAX7219plus_model5::StartScrubber(uint32_t periodMs, uint8_t budget)
+{
+	StopScrubber();
+	_ScrubBudget = budget;
+	if (add_repeating_timer_ms((int32_t)periodMs, ScrubTimerCallback, this, &_ScrubTimer) == false)
+	{
+		printf("Error: StartScrubber 1: No free timer.\n");
+		return -3;
+	}
+	_ScrubRunning = true;
+	return 0;
+}
+
+/*!
+	@brief Stop the background register scrubber
+*/
+void MAX7219plus_model5::StopScrubber(void)
+{
+	if (_ScrubRunning == false) return;
+	cancel_repeating_timer(&_ScrubTimer);
+	_ScrubRunning = false;
+}
+
+/*!
+	@brief Fade the intensity of every display to its own target, in the background
+	@param targets chain length intensities 0x00 to 0x0F, targets[0] for display 1
+	@param durationMs fade time mS
+	@return 0 success , -2 targets null , -3 no free timer
+	@details Each step the intensities are interpolated in perceived lightness (gamma 2.2),
+		so the fade looks even, and sent as one cascade frame for the whole chain.
+		Steps run every MAX7219_FADE_STEP_MS from a repeating timer interrupt, a frame is only
+		sent when a level changes. A step is skipped while the display methods are writing
+		or a DMA flush is running, the next step catches up.
+	@note A new fade replaces a running one, starting from the current intensities.
+		Displays past the chain length, selected with SetCurrentDisplayNumber, keep their intensity.
+*/
+int MAX7219plus_model5::FadeTo(const uint8_t targets[], uint32_t durationMs)
+{
+	if (targets == nullptr)
+	{
+		printf("Error: FadeTo 1: targets is a null pointer.\n");
+		return -2;
+	}
+	StopFade();
+	_FadeChips = FrameChips();
+	for (uint16_t display = 0; display < _FadeChips; display++)
+	{
+		_FadeFrom[display] = _RegisterShadow[display][MAX7219_REG_Intensity] & IntensityMax;
+		_FadeTarget[display] = (display < _ChainLength) ? (targets[display] & IntensityMax) : _FadeFrom[display];
+	}
+	return StartFade(durationMs);
+}
+
+/*!
+	@brief Fade the intensity of every display to the same target, in the background
+	@param target intensity 0x00 to 0x0F
+	@param durationMs fade time mS
+	@return 0 success , -3 no free timer
+	@note See FadeTo, displays at different intensities all arrive together.
+		Every display a frame covers is faded, see FrameChips.
+*/
+int MAX7219plus_model5::FadeAllTo(uint8_t target, uint32_t durationMs)
+{
+	StopFade();
+	_FadeChips = FrameChips();
+	for (uint16_t display = 0; display < _FadeChips; display++)
+	{
+		_FadeFrom[display] = _RegisterShadow[display][MAX7219_REG_Intensity] & IntensityMax;
+		_FadeTarget[display] = target & IntensityMax;
+	}
+	return StartFade(durationMs);
+}
+
+/*!
+	@brief Is a fade running
+	@return true fading
+*/
+bool MAX7219plus_model5::IsFading(void) {return _Fading;}
+
+/*!
+	@brief Stop a running fade, the displays keep their current intensity
+*/
+void MAX7219plus_model5::StopFade(void)
+{
+	if (_Fading == false) return;
+	cancel_repeating_timer(&_FadeTimer);
+	_Fading = false;
+}
+
 // Private methods
 
+/*!
+	@brief Start the fade timer once the start and target intensities are set
+	@param durationMs fade time mS
+	@return 0 success , -3 no free timer
+*/
+int MAX7219plus_model5::StartFade(uint32_t durationMs)
+{
+	_FadeSteps = durationMs / MAX7219_FADE_STEP_MS;
+	if (_FadeSteps == 0) _FadeSteps = 1;
+	_FadeStep = 0;
+	_Fading = true;
+	if (add_repeating_timer_ms(MAX7219_FADE_STEP_MS, FadeTimerCallback, this, &_FadeTimer) == false)
+	{
+		_Fading = false;
+		printf("Error: FadeTo 2: No free timer.\n");
+		return -3;
+	}
+	return 0;
+}
+
+/*!
+	@brief Repeating timer callback of the fade engine
+	@param timer the fade timer, user_data is the instance
+	@return true keep the timer running, false fade complete
+*/
+bool MAX7219plus_model5::FadeTimerCallback(repeating_timer_t *timer)
+{
+	MAX7219plus_model5 *display = static_cast<MAX7219plus_model5 *>(timer->user_data);
+	display->FadeTick();
+	return display->_Fading;
+}
+
+/*!
+	@brief One fade step, send the intensities of this step if any changed
+*/
+void MAX7219plus_model5::FadeTick(void)
+{
+	if (_FadeStep < _FadeSteps) _FadeStep++;
+	if (_BusActive == true || _FlushBusy == true) return;
+
+	// The frame covers every display the display methods reach, those not fading keep their level
+	uint16_t chips = FrameChips();
+	bool changed = false;
+	for (uint16_t display = 1; display <= chips; display++)
+	{
+		uint8_t level = _RegisterShadow[display - 1][MAX7219_REG_Intensity];
+		if (display <= _FadeChips)
+		{
+			level = FadeLevel(display - 1);
+			if (level != _RegisterShadow[display - 1][MAX7219_REG_Intensity]) changed = true;
+		}
+		_FadeBuffer[chips - display] = FrameWord(MAX7219_REG_Intensity, level);
+	}
+	if (changed == true)
+	{
+		SendFrame(_FadeBuffer, chips);
+		for (uint16_t display = 1; display <= chips; display++)
+		{
+			_RegisterShadow[display - 1][MAX7219_REG_Intensity] = _FadeBuffer[chips - display] & 0xFF;
+		}
+	}
+	if (_FadeStep >= _FadeSteps) _Fading = false;
+}
+
+/*!
+	@brief Intensity level of one display at the current fade step
+	@param display display index 0 to _FadeChips - 1
+	@return intensity 0x00 to 0x0F with the perceived lightness nearest the interpolated one
+*/
+uint8_t MAX7219plus_model5::FadeLevel(uint16_t display)
+{
+	int32_t from = _FadeLightness[_FadeFrom[display]];
+	int32_t to = _FadeLightness[_FadeTarget[display]];
+	int32_t lightness = from + (to - from) * (int32_t)_FadeStep / (int32_t)_FadeSteps;
+
+	uint8_t level = 0;
+	for (uint8_t i = 1; i < 16; i++)
+	{
+		if (abs(_FadeLightness[i] - lightness) < abs(_FadeLightness[level] - lightness)) level = i;
+	}
+	return level;
+}
+
+/*!
+	@brief Repeating timer callback of the register scrubber
+	@param timer the scrubber timer, user_data is the instance
+	@return true keep the timer running
+*/
+bool MAX7219plus_model5::ScrubTimerCallback(repeating_timer_t *timer)
+{
+	MAX7219plus_model5 *display = static_cast<MAX7219plus_model5 *>(timer->user_data);
+	display->ScrubRegisters(display->_ScrubBudget);
+	return true;
+}
+
  /*!
-	@brief Shifts out a uint8_t of data on to the MAX7219 SPI-like bus
-	@param value The uint8_t of data to shift out
-	@note _CommDelay microsecond delay may have to be adjusted depending on processor
+	@brief Shifts out a register/data word on to the MAX7219 SPI-like bus
+	@param value The 16 bit word to shift out, register in the upper byte
+	@note _CommTiming delay may have to be adjusted depending on processor
 */
-void MAX7219plus_model5::HighFreqshiftOut(uint8_t value)
+void MAX7219plus_model5::HighFreqshiftOut(uint16_t value)
 {
 
-	for (uint8_t bit = 0; bit < 8; bit++)
+	for (uint8_t bit = 0; bit < 16; bit++)
 	{
-		!!(value & (1 << (7 - bit))) ? gpio_put(_Display_SDATA, true): gpio_put(_Display_SDATA, false); // MSBFIRST
+		!!(value & (1 << (15 - bit))) ? gpio_put(_Display_SDATA, true): gpio_put(_Display_SDATA, false); // MSBFIRST
 		gpio_put(_Display_SCLK, true);
-		busy_wait_us(_CommDelay);
+		_CommTiming.wait();
 		gpio_put(_Display_SCLK, false);
-		busy_wait_us(_CommDelay);
+		_CommTiming.wait();
 	}
 }
 
@@ -492,8 +1040,9 @@ uint8_t MAX7219plus_model5::ASCIIFetch(uint8_t character, DecimalPoint_e decimal
 		character = '0';
 	} 
 	uint8_t returnCharValue =0;
-	const uint8_t *font = SevenSegmentFont::pFontSevenSegptr();
-	returnCharValue = flipBitsPreserveMSB(font[character - _ASCII_FONT_OFFSET]);
+	// MAX7219 segment order is dp-abcdefg, table generated from the shared dp-gfedcba font at compile time
+	const uint8_t *font = SevenSegmentFont::pFontSevenSegptr<SegmentOrder_e::DpABCDEFG>();
+	returnCharValue = font[character - _ASCII_FONT_OFFSET];
 	switch (decimalPoint)
 	{
 		case DecPointOn  :  returnCharValue |= DEC_POINT_7_MASK; break;
@@ -504,43 +1053,314 @@ uint8_t MAX7219plus_model5::ASCIIFetch(uint8_t character, DecimalPoint_e decimal
 }
 
 /*!
-	@brief Write to the MAX7219 display register
+	@brief Write to the MAX7219 display register of the current display
 	@param RegisterCode the register to write to
 	@param data The data byte to send to register
+	@note The other displays in the chain get a NOP. The value is kept in the register shadow,
+		in deferred mode digit registers are only written to the shadow, see RefreshChain.
 */
 void MAX7219plus_model5::WriteDisplay( uint8_t RegisterCode, uint8_t data)
 {
+	_RegisterShadow[_CurrentDisplayNumber - 1][RegisterCode & 0x0F] = data;
+	if (_DeferredMode == true && RegisterCode >= 1 && RegisterCode <= 8) return;
 
-	if (_HardwareSPI == false)
+	// The frame buffer holds NOP for every display, only the target word is set and restored
+	uint16_t chips = FrameChips();
+	uint16_t index = chips - _CurrentDisplayNumber;
+	_FrameBuffer[index] = FrameWord(RegisterCode, data);
+	SendFrame(_FrameBuffer, chips);
+	_FrameBuffer[index] = MAX7219_REG_NOP;
+}
+
+/*!
+	@brief Number of displays a frame must cover
+	@return the larger of the chain length and the highest display number selected
+	@note A frame shorter than the chain re-latches stale words in the displays past its end.
+*/
+uint16_t MAX7219plus_model5::FrameChips(void)
+{
+	return (_ChainLength > _HighestDisplay) ? _ChainLength : _HighestDisplay;
+}
+
+/*!
+	@brief Set the frame buffer words of a whole chain frame back to NOP
+	@param chips number of words to clear
+*/
+void MAX7219plus_model5::ClearFrame(uint16_t chips)
+{
+	memset(_FrameBuffer, MAX7219_REG_NOP, chips * sizeof(uint16_t));
+}
+
+/*!
+	@brief Send one frame to the cascade and latch it with a single CS pulse
+	@param frame register/data words, register in the upper byte, first word for the last
+		display in the chain, last word for display 1 (nearest the PICO)
+	@param chips number of words in frame
+*/
+void MAX7219plus_model5::SendFrame(const uint16_t *frame, uint16_t chips)
+{
+	_BusActive = true;
+	if (_pio != nullptr)
+	{
+		// The PIO frames the words with CS, returns once they are queued
+		pio_sm_put_blocking(_pio, _pioSM, chips - 1);
+		for (uint16_t i = 0; i < chips; i++)
+		{
+			pio_sm_put_blocking(_pio, _pioSM, (uint32_t)frame[i] << 16);
+		}
+	}else if (_HardwareSPI == false)
 	{
+		_CommTiming.update();
 		gpio_put(_Display_CS, false);
-		HighFreqshiftOut(RegisterCode);
-		HighFreqshiftOut(data);
-		if (_CurrentDisplayNumber  > 1)
+		for (uint16_t i = 0; i < chips; i++)
 		{
-			for (uint8_t i= 1 ; i <_CurrentDisplayNumber; i++)
-			{
-				HighFreqshiftOut(MAX7219_REG_NOP);
-				HighFreqshiftOut(0x00);
-			}
+			HighFreqshiftOut(frame[i]);
 		}
 		gpio_put(_Display_CS, true);
 	}else
 	{
-		uint8_t TransmitBuffer[_CurrentDisplayNumber*2];
-		TransmitBuffer[0] = RegisterCode;
-		TransmitBuffer[1] = data;
-		if (_CurrentDisplayNumber  > 1)
-		{
-			for (uint8_t i= 2 ; i < (_CurrentDisplayNumber*2) ; i++)
-			{
-				TransmitBuffer[i] = 0x00;
-			}
-		}
+		WaitFlush();
 		gpio_put(_Display_CS, false);
-		spi_write_blocking(_pspiInterface, TransmitBuffer, sizeof(TransmitBuffer));
+		spi_write16_blocking(_pspiInterface, frame, chips);
 		gpio_put(_Display_CS, true);
 	}
+	_BusActive = false;
+}
+
+/*!
+	@brief Claim a DMA channel for the asynchronous flush, 16 bit writes to the SPI data register
+	@return 0 success , -4 no free channel
+*/
+int MAX7219plus_model5::FlushClaimDMA(void)
+{
+	int channel = dma_claim_unused_channel(false);
+	if (channel < 0) return -4;
+
+	dma_channel_config config = dma_channel_get_default_config(channel);
+	channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+	channel_config_set_dreq(&config, spi_get_dreq(_pspiInterface, true));
+	channel_config_set_read_increment(&config, true);
+	channel_config_set_write_increment(&config, false);
+	dma_channel_configure(channel, &config, &spi_get_hw(_pspiInterface)->dr, nullptr, 0, false);
+
+	_DMAOwner[channel] = this;
+	_DMAChannel = channel;
+	if (_DMAIRQInstalled == false)
+	{
+		irq_add_shared_handler(DMA_IRQ_0, DMAIRQHandler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+		irq_set_enabled(DMA_IRQ_0, true);
+		_DMAIRQInstalled = true;
+	}
+	dma_channel_set_irq0_enabled(channel, true);
+	return 0;
+}
+
+/*!
+	@brief Release the DMA channel of the asynchronous flush
+*/
+void MAX7219plus_model5::FlushReleaseDMA(void)
+{
+	if (_DMAChannel < 0) return;
+	dma_channel_set_irq0_enabled(_DMAChannel, false);
+	_DMAOwner[_DMAChannel] = nullptr;
+	dma_channel_unclaim(_DMAChannel);
+	_DMAChannel = -1;
+}
+
+/*!
+	@brief Build the digit register frames of a flush from the register shadow
+	@return buffer index 0-1 built , -3 software SPI , -4 no free DMA channel
+	@note Builds into the buffer the DMA is not sending, see FlushCommit.
+		Frames cover FrameChips() displays, as RefreshChain.
+*/
+int MAX7219plus_model5::FlushPrepare(void)
+{
+	if (_HardwareSPI == false)
+	{
+		printf("Error: FlushAsync 1: Hardware SPI only.\n");
+		return -3;
+	}
+	if (_DMAChannel < 0 && FlushClaimDMA() != 0)
+	{
+		printf("Error: FlushAsync 2: No free DMA channel.\n");
+		return -4;
+	}
+
+	// Claim the buffer the DMA is not sending
+	uint32_t status = save_and_disable_interrupts();
+	_FlushPending = false;
+	uint8_t spare = _FlushBusy ? (_FlushActive ^ 1) : _FlushActive;
+	restore_interrupts(status);
+
+	uint16_t chips = FrameChips();
+	for (uint8_t digit = 1; digit <= _NoDigits; digit++)
+	{
+		uint16_t *frame = _FlushBuffer[spare][digit - 1];
+		for (uint16_t display = 1; display <= chips; display++)
+		{
+			frame[chips - display] = FrameWord(digit, _RegisterShadow[display - 1][digit]);
+		}
+	}
+	_FlushFrames[spare] = _NoDigits;
+	_FlushChips[spare] = chips;
+	return spare;
+}
+
+/*!
+	@brief Start or queue a flush built by FlushPrepare, call with interrupts disabled
+	@param spare buffer index returned by FlushPrepare
+	@param trigger true start the DMA now, false only arm it, the caller starts it
+		with dma_start_channel_mask
+	@return true the DMA is armed for this flush , false queued behind a running flush
+*/
+bool MAX7219plus_model5::FlushCommit(uint8_t spare, bool trigger)
+{
+	if (_FlushBusy == true)
+	{
+		_FlushPending = true;
+		return false;
+	}
+	_FlushActive = spare;
+	_FlushFrame = 0;
+	_FlushBusy = true;
+	gpio_put(_Display_CS, false);
+	if (trigger == true)
+	{
+		FlushStartFrame();
+	}else
+	{
+		dma_channel_set_read_addr(_DMAChannel, _FlushBuffer[_FlushActive][0], false);
+		dma_channel_set_trans_count(_DMAChannel, _FlushChips[_FlushActive], false);
+	}
+	return true;
+}
+
+/*!
+	@brief Start the DMA of the current frame of the active buffer, CS is already low
+*/
+void MAX7219plus_model5::FlushStartFrame(void)
+{
+	dma_channel_transfer_from_buffer_now(_DMAChannel, _FlushBuffer[_FlushActive][_FlushFrame],
+		_FlushChips[_FlushActive]);
+}
+
+/*!
+	@brief DMA IRQ work for one frame, latch it and start the next frame or flush
+	@note The DMA completes when the last word enters the SPI TX FIFO, so wait for the
+		FIFO to drain (at most 8 words) before CS goes high.
+*/
+void MAX7219plus_model5::FlushFrameDone(void)
+{
+	while (spi_is_busy(_pspiInterface))
+	{
+		tight_loop_contents();
+	}
+	// Discard the words clocked in, and clear the receive overrun
+	while (spi_is_readable(_pspiInterface))
+	{
+		(void)spi_get_hw(_pspiInterface)->dr;
+	}
+	spi_get_hw(_pspiInterface)->icr = SPI_SSPICR_RORIC_BITS;
+	gpio_put(_Display_CS, true);
+
+	_FlushFrame++;
+	if (_FlushFrame >= _FlushFrames[_FlushActive])
+	{
+		if (_FlushPending == false)
+		{
+			_FlushBusy = false;
+			if (_FlushCallback != nullptr) _FlushCallback(_FlushCallbackContext);
+			return;
+		}
+		_FlushPending = false;
+		_FlushActive ^= 1;
+		_FlushFrame = 0;
+	}
+	gpio_put(_Display_CS, false); // CS high time is well over the 50nS minimum
+	FlushStartFrame();
+}
+
+/*!
+	@brief Shared DMA_IRQ_0 handler, passes each completed channel to its instance
+*/
+void MAX7219plus_model5::DMAIRQHandler(void)
+{
+	for (uint8_t channel = 0; channel < NUM_DMA_CHANNELS; channel++)
+	{
+		if (_DMAOwner[channel] != nullptr && dma_channel_get_irq0_status(channel))
+		{
+			dma_channel_acknowledge_irq0(channel);
+			_DMAOwner[channel]->FlushFrameDone();
+		}
+	}
+}
+
+/*!
+	@brief Load the SPI program, claim a state machine and hand the pins to PIO.
+	@return true success, false no free state machine or instruction memory
+	@note The program is loaded once per PIO block and shared by all instances.
+*/
+bool MAX7219plus_model5::PIOBegin(void)
+{
+	uint pioIndex = pio_get_index(_pio);
+	_pioSM = pio_claim_unused_sm(_pio, false);
+	if (_pioSM < 0)
+	{
+		return false;
+	}
+	if (_pioProgramOffset[pioIndex] < 0)
+	{
+		if (!pio_can_add_program(_pio, &max7219_spi_program))
+		{
+			pio_sm_unclaim(_pio, _pioSM);
+			_pioSM = -1;
+			return false;
+		}
+		_pioProgramOffset[pioIndex] = (int8_t)pio_add_program(_pio, &max7219_spi_program);
+	}
+	_pioProgramUsers[pioIndex]++;
+
+	// 4 PIO cycles per bit on the bus
+	float clkdiv = (float)clock_get_hz(clk_sys) / (float)(_speedSPIKHz * 1000 * 4);
+	if (clkdiv < 1.0f) clkdiv = 1.0f;
+	max7219_spi_program_init(_pio, _pioSM, _pioProgramOffset[pioIndex], _Display_SCLK, _Display_CS, _Display_SDATA, clkdiv);
+	return true;
+}
+
+/*!
+	@brief Wait for the SPI transmitter to finish, release the state machine and program.
+*/
+void MAX7219plus_model5::PIOClose(void)
+{
+	if (_pioSM < 0) return;
+	uint pioIndex = pio_get_index(_pio);
+	PIOWaitIdle();
+	pio_sm_set_enabled(_pio, _pioSM, false);
+	pio_sm_unclaim(_pio, _pioSM);
+	_pioSM = -1;
+	if (_pioProgramUsers[pioIndex] > 0 && --_pioProgramUsers[pioIndex] == 0)
+	{
+		pio_remove_program(_pio, &max7219_spi_program, _pioProgramOffset[pioIndex]);
+		_pioProgramOffset[pioIndex] = -1;
+	}
+}
+
+/*!
+	@brief Block until every queued frame has been clocked out and latched by the state machine.
+*/
+void MAX7219plus_model5::PIOWaitIdle(void)
+{
+	uint32_t stallMask = 1u << (PIO_FDEBUG_TXSTALL_LSB + _pioSM);
+	while (!pio_sm_is_tx_fifo_empty(_pio, _pioSM))
+	{
+		tight_loop_contents();
+	}
+	// The transmitter stalls on the frame header pull once the last frame is latched
+	_pio->fdebug = stallMask;
+	while (!(_pio->fdebug & stallMask))
+	{
+		tight_loop_contents();
+	}
 }
 
 /*!
@@ -563,29 +1383,4 @@ void MAX7219plus_model5::SetScanLimit(ScanLimit_e numDigits)
 	WriteDisplay(MAX7219_REG_ScanLimit, numDigits);
 }
 
-/*!
-	@brief Flips the positions of bits in a byte while preserving the MSB bit
-	@param byte A byte of data, ASCII character
-	@return A byte from font representing LED segment data with bits positions flipped and MSB bit value preserved 
-	@details The reason for this function is that the MAX7219 requires ASCII segment data
-	in following order : dp-abcdefg but the font we use is dp-gfedcba where
-	letters represent seven segment LEDS, and dp represents decimal point.. 
-	We flip the bits in the code rather than change the font data in font file because
-	the font data is used by other modules(TM1638 + TM1637) and they use dp-gfedcba order.
-	Thus we can share same font file between all seven segment modules.
-*/
-uint8_t MAX7219plus_model5::flipBitsPreserveMSB(uint8_t byte) 
-{
-	uint8_t msb = byte & DEC_POINT_7_MASK; // Extract the most significant bit (MSB)
-	uint8_t flipped = 0;       // Variable to store the flipped result
-	for (int i = 0; i < 7; ++i) 
-	{
-		// Shift the i-th bit from the rightmost 7 bits to the new position
-		if (byte & (1 << i)) 
-		{
-			flipped |= (1 << (6 - i));
-		}
-	}
-	return msb | flipped; // Combine the saved MSB with the flipped bits
-}
 // == EOF ==
@@ -0,0 +1,153 @@
+/*!
+	@file     max7219_group.cpp
+	@author   Gavin Lyons
+	@brief    PICO library source file for MAX7219 chains refreshed in parallel on spi0 and spi1.
+*/
+
+#include "pico/stdlib.h"
+#include "displaylib_LED_PICO/max7219_group.hpp"
+
+/*!
+	@brief Constructor for class MAX7219ChainGroup
+*/
+MAX7219ChainGroup::MAX7219ChainGroup(void)
+{
+	for (uint8_t i = 0; i < MAX7219_GROUP_MAX_CHAINS; i++)
+	{
+		_slots[i].group = this;
+		_slots[i].index = i;
+	}
+}
+
+/*!
+	@brief Add a chain to the group
+	@param chain a MAX7219 object using hardware SPI
+	@return chain index 0-1 for success, -2 group full, -3 chain not hardware SPI or
+		SPI instance already in the group
+	@note The group sets the flush callback of the chain, use
+		MAX7219ChainGroup::SetFlushCallback instead. Chain length and deferred mode
+		are set on the chain object as normal.
+*/
+int MAX7219ChainGroup::AddChain(MAX7219plus_model5 &chain)
+{
+	if (_chainCount >= MAX7219_GROUP_MAX_CHAINS)
+	{
+		printf("Error: AddChain 1: Group is full, %u chains maximum.\n", MAX7219_GROUP_MAX_CHAINS);
+		return -2;
+	}
+	if (chain._HardwareSPI == false)
+	{
+		printf("Error: AddChain 2: Chains in a group must use hardware SPI.\n");
+		return -3;
+	}
+	for (uint8_t i = 0; i < _chainCount; i++)
+	{
+		if (_chains[i]->_pspiInterface == chain._pspiInterface)
+		{
+			printf("Error: AddChain 3: SPI instance already in group.\n");
+			return -3;
+		}
+	}
+	chain.SetFlushCallback(ChainDone, &_slots[_chainCount]);
+	_chains[_chainCount] = &chain;
+	return _chainCount++;
+}
+
+/*!
+	@brief Get number of chains in the group
+	@return number of chains 0-2
+*/
+uint8_t MAX7219ChainGroup::GetChainCount(void) const
+{
+	return _chainCount;
+}
+
+/*!
+	@brief Write the digit registers of every chain from their register shadows, without waiting
+	@return 0 success , -3 a chain is not hardware SPI , -4 no free DMA channel
+	@note The frames of all chains are built first, then the DMA of every idle chain is
+		started with one dma_start_channel_mask. A chain still busy from the last flush
+		queues its new frames and starts them when it completes.
+*/
+int MAX7219ChainGroup::FlushAsync(void)
+{
+	int spare[MAX7219_GROUP_MAX_CHAINS];
+	for (uint8_t i = 0; i < _chainCount; i++)
+	{
+		spare[i] = _chains[i]->FlushPrepare();
+		if (spare[i] < 0) return spare[i];
+	}
+
+	uint32_t channelMask = 0;
+	uint32_t status = save_and_disable_interrupts();
+	for (uint8_t i = 0; i < _chainCount; i++)
+	{
+		if (_chains[i]->FlushCommit(spare[i], false) == true)
+		{
+			channelMask |= (1u << _chains[i]->_DMAChannel);
+		}
+	}
+	if (channelMask != 0) dma_start_channel_mask(channelMask);
+	restore_interrupts(status);
+	return 0;
+}
+
+/*!
+	@brief Is a flush running or queued on any chain
+	@return true busy
+*/
+bool MAX7219ChainGroup::IsFlushBusy(void) const
+{
+	for (uint8_t i = 0; i < _chainCount; i++)
+	{
+		if (_chains[i]->_FlushBusy == true) return true;
+	}
+	return false;
+}
+
+/*!
+	@brief Is a flush running or queued on one chain
+	@param chain chain index returned by AddChain
+	@return true busy, false idle or no such chain
+*/
+bool MAX7219ChainGroup::IsChainBusy(uint8_t chain) const
+{
+	if (chain >= _chainCount) return false;
+	return _chains[chain]->_FlushBusy;
+}
+
+/*!
+	@brief Wait until every chain has completed its flush
+*/
+void MAX7219ChainGroup::WaitFlush(void)
+{
+	for (uint8_t i = 0; i < _chainCount; i++)
+	{
+		_chains[i]->WaitFlush();
+	}
+}
+
+/*!
+	@brief Set the function called when a chain completes its flush
+	@param callback function, called from the DMA interrupt with the chain index, nullptr for none
+	@param context argument passed to callback
+	@note The group flush is complete when IsFlushBusy() returns false in the callback.
+*/
+void MAX7219ChainGroup::SetFlushCallback(void (*callback)(uint8_t chain, void *context), void *context)
+{
+	uint32_t status = save_and_disable_interrupts();
+	_callback = callback;
+	_callbackContext = context;
+	restore_interrupts(status);
+}
+
+/*!
+	@brief Flush callback of every chain, passes the chain index to the group callback
+	@param context the ChainSlot_t of the chain
+*/
+void MAX7219ChainGroup::ChainDone(void *context)
+{
+	ChainSlot_t *slot = static_cast<ChainSlot_t *>(context);
+	MAX7219ChainGroup *group = slot->group;
+	if (group->_callback != nullptr) group->_callback(slot->index, group->_callbackContext);
+}
@@ -0,0 +1,246 @@
+/*!
+	@file     max7219_matrix.cpp
+	@author   Gavin Lyons
+	@brief    PICO library source file for 8x8 LED matrix modules driven by a MAX7219 chain.
+*/
+
+#include <cstring>
+#include "pico/stdlib.h"
+#include "displaylib_LED_PICO/max7219_matrix.hpp"
+
+/*!
+	@brief Constructor for class MAX7219Matrix
+	@param chain the MAX7219 object of the module chain
+*/
+MAX7219Matrix::MAX7219Matrix(MAX7219plus_model5 &chain)
+{
+	_chain = &chain;
+}
+
+/*!
+	@brief Set up the chain for matrix modules and clear them
+	@param modules number of 8x8 modules in the chain
+	@return 0 for success, -3 modules outside 1 to MAX7219_MAX_CHAIN
+	@note Sets the chain length, eight digit scan, no decode mode and deferred mode,
+		so the digit registers are only written by Flush().
+*/
+int MAX7219Matrix::Begin(uint16_t modules)
+{
+	if (modules == 0 || modules > MAX7219plus_model5::MAX7219_MAX_CHAIN)
+	{
+		printf("Error: Begin 1: Module count must be 1 to %u.\n", MAX7219plus_model5::MAX7219_MAX_CHAIN);
+		return -3;
+	}
+	_modules = modules;
+	_words = (modules * 8 + 31) / 32;
+	Clear();
+	_chain->SetChainLength(modules);
+	_chain->InitDisplayAll(MAX7219plus_model5::ScanEightDigit, MAX7219plus_model5::DecodeModeNone);
+	_chain->SetDeferredMode(true);
+	return 0;
+}
+
+/*!
+	@brief Get width of the display
+	@return width in pixels, 8 per module
+*/
+uint16_t MAX7219Matrix::GetWidth(void) const
+{
+	return _modules * 8;
+}
+
+/*!
+	@brief Set the orientation of the image on each module
+	@param orientation rotation, depends on how the modules are built
+*/
+void MAX7219Matrix::SetOrientation(MatrixOrientation_e orientation)
+{
+	_orientation = orientation;
+}
+
+/*!
+	@brief Get the orientation of the image on each module
+	@return orientation
+*/
+MAX7219Matrix::MatrixOrientation_e MAX7219Matrix::GetOrientation(void) const
+{
+	return _orientation;
+}
+
+/*!
+	@brief Set which end of the chain is the left of the display
+	@param firstLeft true display 1 (nearest the PICO) is the leftmost module,
+		false (default) it is the rightmost
+*/
+void MAX7219Matrix::SetFirstModuleLeft(bool firstLeft)
+{
+	_firstLeft = firstLeft;
+}
+
+/*!
+	@brief Clear the framebuffer
+*/
+void MAX7219Matrix::Clear(void)
+{
+	memset(_rows, 0, sizeof(_rows));
+}
+
+/*!
+	@brief Set or clear one pixel in the framebuffer
+	@param x column 0 (left) to width-1
+	@param y row 0 (top) to 7
+	@param on true LED on
+*/
+void MAX7219Matrix::SetPixel(uint16_t x, uint8_t y, bool on)
+{
+	if (x >= GetWidth() || y > 7) return;
+	uint32_t mask = 0x80000000u >> (x % 32);
+	if (on) _rows[y][x / 32] |= mask;
+	else _rows[y][x / 32] &= ~mask;
+}
+
+/*!
+	@brief Get one pixel from the framebuffer
+	@param x column 0 (left) to width-1
+	@param y row 0 (top) to 7
+	@return true LED on, false off or outside display
+*/
+bool MAX7219Matrix::GetPixel(uint16_t x, uint8_t y) const
+{
+	if (x >= GetWidth() || y > 7) return false;
+	return (_rows[y][x / 32] >> (31 - (x % 32))) & 0x01;
+}
+
+/*!
+	@brief Set a whole column of pixels
+	@param x column 0 (left) to width-1
+	@param column bit 0 top row to bit 7 bottom row
+	@note For tickers, ScrollLeft(1) then SetColumn(GetWidth() - 1, glyph column).
+*/
+void MAX7219Matrix::SetColumn(uint16_t x, uint8_t column)
+{
+	for (uint8_t y = 0; y < 8; y++)
+	{
+		SetPixel(x, y, (column >> y) & 0x01);
+	}
+}
+
+/*!
+	@brief Scroll the framebuffer left, blank columns enter on the right
+	@param pixels number of columns
+*/
+void MAX7219Matrix::ScrollLeft(uint16_t pixels)
+{
+	uint16_t wordShift = pixels / 32;
+	uint8_t bitShift = pixels % 32;
+	for (uint8_t y = 0; y < 8; y++)
+	{
+		uint32_t *row = _rows[y];
+		for (uint16_t i = 0; i < _words; i++)
+		{
+			uint32_t high = (i + wordShift < _words) ? row[i + wordShift] : 0;
+			uint32_t low = (i + wordShift + 1 < _words) ? row[i + wordShift + 1] : 0;
+			row[i] = bitShift ? (high << bitShift) | (low >> (32 - bitShift)) : high;
+		}
+	}
+}
+
+/*!
+	@brief Scroll the framebuffer right, blank columns enter on the left
+	@param pixels number of columns
+*/
+void MAX7219Matrix::ScrollRight(uint16_t pixels)
+{
+	uint16_t wordShift = pixels / 32;
+	uint8_t bitShift = pixels % 32;
+	for (uint8_t y = 0; y < 8; y++)
+	{
+		uint32_t *row = _rows[y];
+		for (int i = _words - 1; i >= 0; i--)
+		{
+			uint32_t low = (i >= wordShift) ? row[i - wordShift] : 0;
+			uint32_t high = (i >= wordShift + 1) ? row[i - wordShift - 1] : 0;
+			row[i] = bitShift ? (low >> bitShift) | (high << (32 - bitShift)) : low;
+		}
+	}
+	MaskTail();
+}
+
+/*!
+	@brief Write the framebuffer to the modules, one cascade frame per row
+	@note Blocks until sent, see FlushAsync.
+*/
+void MAX7219Matrix::Flush(void)
+{
+	UpdateShadow();
+	_chain->RefreshChain();
+}
+
+/*!
+	@brief Write the framebuffer to the modules without waiting, hardware SPI chains only
+	@return 0 success , -3 chain not hardware SPI , -4 no free DMA channel
+	@note The frames are copied, so the framebuffer can be drawn at once.
+*/
+int MAX7219Matrix::FlushAsync(void)
+{
+	UpdateShadow();
+	return _chain->FlushAsync();
+}
+
+// Private methods
+
+/*!
+	@brief Clear the pixels past the display width in the last word of each strip
+	@note ScrollRight moves pixels there, ScrollLeft would bring them back.
+*/
+void MAX7219Matrix::MaskTail(void)
+{
+	uint8_t used = (_modules * 8) % 32;
+	if (used == 0) return;
+	uint32_t mask = ~(0xFFFFFFFFu >> used);
+	for (uint8_t y = 0; y < 8; y++)
+	{
+		_rows[y][_words - 1] &= mask;
+	}
+}
+
+/*!
+	@brief Cut the 8x8 block of one module out of the row strips
+	@param module module 0 (left) to modules-1
+	@return packed matrix, byte r = row r, bit 7 = left column
+*/
+uint64_t MAX7219Matrix::ModuleBlock(uint16_t module) const
+{
+	uint16_t word = module / 4;
+	uint8_t shift = 24 - 8 * (module % 4);
+	uint64_t block = 0;
+	for (uint8_t y = 0; y < 8; y++)
+	{
+		block |= (uint64_t)((_rows[y][word] >> shift) & 0xFF) << (8 * y);
+	}
+	return block;
+}
+
+/*!
+	@brief Write every module block, in module orientation, to the chain register shadow
+*/
+void MAX7219Matrix::UpdateShadow(void)
+{
+	for (uint16_t module = 0; module < _modules; module++)
+	{
+		uint64_t block = ModuleBlock(module);
+		switch (_orientation)
+		{
+			case MatrixRotate0: break;
+			case MatrixRotate90: block = BitMatrix::flipVertical(BitMatrix::transpose8x8(block)); break;
+			case MatrixRotate180: block = BitMatrix::flipHorizontal(BitMatrix::flipVertical(block)); break;
+			case MatrixRotate270: block = BitMatrix::flipHorizontal(BitMatrix::transpose8x8(block)); break;
+		}
+		uint16_t display = _firstLeft ? module : (_modules - 1 - module);
+		uint8_t *shadow = _chain->_RegisterShadow[display];
+		for (uint8_t row = 0; row < 8; row++)
+		{
+			shadow[row + 1] = (uint8_t)(block >> (8 * row));
+		}
+	}
+}
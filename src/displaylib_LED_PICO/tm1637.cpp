@@ -5,6 +5,13 @@
 */
 
 #include "../../include/displaylib_LED_PICO/tm1637.hpp"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include "hardware/structs/systick.h"
+#include "tm1637.pio.h"
+
+int8_t TM1637plus_model4::_pioProgramOffset[2] = {-1, -1};
+uint8_t TM1637plus_model4::_pioProgramUsers[2] = {0, 0};
 
 /*!
 	@brief Initialize a TM1637 object
@@ -12,14 +19,31 @@
 	@param data GPIO connected to the DIO pin of the module
 	@param delay microseconds delay, between bit transition on the serial
 			bus connected to the display
-	@param displaySize number of digits in display.
+	@param displaySize number of digits in display 1-6.
+	@param pio PIO instance (pio0 or pio1) to run the bus engine on,
+		default nullptr , bit-banged GPIO is used and delay applies.
+	@param digitMap grid address (0-5) of each digit left to right, displaySize entries,
+		default nullptr = digit n on grid n. Use TM1637_DIGIT_MAP_6 for the common 6 digit modules.
 */
-TM1637plus_model4::TM1637plus_model4(uint8_t clock, uint8_t data, int delay, int displaySize)
+TM1637plus_model4::TM1637plus_model4(uint8_t clock, uint8_t data, int delay, int displaySize, PIO pio, const uint8_t *digitMap)
 {
+	_pio = pio;
 	_DATA_IO = data;
 	_CLOCK_IO = clock;
-	_BitDelayUS = delay;
+	_BitDelay.setDelayNs((uint32_t)delay * 1000);
+	if (displaySize < 1 || displaySize > _TM1637_MAX_DIGITS)
+	{
+		printf("Error: TM1637plus_model4 1: Display size must be 1-6, using %u.\n", _TM1637_MAX_DIGITS);
+		displaySize = _TM1637_MAX_DIGITS;
+	}
 	_DisplaySize = displaySize;
+	if (digitMap != nullptr)
+	{
+		for (uint8_t i = 0; i < _DisplaySize; i++)
+		{
+			_digitMap[i] = digitMap[i] % _TM1637_MAX_DIGITS;
+		}
+	}
 }
 
 /*! 
@@ -27,15 +51,23 @@ TM1637plus_model4::TM1637plus_model4(uint8_t clock, uint8_t data, int delay, int
 */
 void  TM1637plus_model4::displayClear()
 {
-	uint8_t data[_DisplaySize] = {0};
+	uint8_t data[_TM1637_MAX_DIGITS] = {0};
 	setSegments(data, _DisplaySize, 0);
 }
 /*!
 	@brief Begin method , set and claims GPIO
-	@note Call in Setup
+	@note Call in Setup. If the PIO transport cannot be started (no free state machine or
+		instruction memory) the driver falls back to bit-banged GPIO.
 */
 void TM1637plus_model4::displayBegin(void)
 {
+	if (_pio != nullptr && PIOBegin() == false)
+	{
+		printf("Error: displayBegin 1: PIO transport unavailable, using GPIO.\n");
+		_pio = nullptr;
+	}
+	forceResync();
+	if (isPIOTransport()) return;
 	gpio_init(_DATA_IO);
 	gpio_init(_CLOCK_IO);
 	gpio_set_dir(_DATA_IO, GPIO_IN);
@@ -64,27 +96,124 @@ void TM1637plus_model4::setBrightness(uint8_t brightness, bool on)
 	argument is the number of digits to be set. Other digits are not affected.
 	@param segments An array of size length containing the raw segment values
 	@param length The number of digits to be modified
-	@param position The position from which to start the modification (0 - leftmost, 3 - rightmost)
+	@param position The position from which to start the modification (0 - leftmost, display size - 1 rightmost)
+	@note The digits are stored in a shadow frame through the digit map and the whole frame
+		is written in one auto increment transaction, so any display size costs one frame.
+		The data command and display control frames are only sent when they differ
+		from what was last sent, usually only the address + data frame goes on the bus.
+		See forceResync. In asynchronous mode the frame is queued and the call returns at once.
 */
 void TM1637plus_model4::setSegments(const uint8_t segments[], uint8_t length, uint8_t position)
 {
-	// Write Command 1
-	CommStart();
-	writeByte(_TM1637_COMMAND_1);
-	CommStop();
+	uint8_t frame[_TM1637_MAX_DIGITS + 1];
+	if (position >= _DisplaySize)
+	{
+		printf("Error: setSegments 2: Position %u is outside display.\n", position);
+		return;
+	}
+	if (length > _DisplaySize - position) length = _DisplaySize - position;
+	for (uint8_t i = 0; i < length; i++)
+	{
+		_frame[_digitMap[position + i]] = segments[i];
+	}
+	if (_deferredMode == true) return;
+	uint8_t grids = gridCount();
 
-	// Write Command 2 + first digit address
-	CommStart();
-	writeByte(_TM1637_COMMAND_2 + (position & 0x03));
-	// Write the data
-	for (uint8_t i=0; i < length; i++)
-		writeByte(segments[i]);
-	CommStop();
+	if (_asyncMode == true && !isPIOTransport())
+	{
+		uint32_t status = save_and_disable_interrupts();
+		_mailbox[0] = _TM1637_COMMAND_2;
+		memcpy(&_mailbox[1], _frame, grids);
+		_mailboxLength = grids + 1;
+		_mailboxFull = true;
+		if (_asyncBusy == false)
+		{
+			// alarm period is the bit delay rounded up to whole microseconds
+			_asyncDelayUs = (_BitDelay.getDelayNs() + 999) / 1000;
+			if (_asyncDelayUs == 0) _asyncDelayUs = 1;
+			asyncLoadJob();
+			_asyncBusy = true;
+			if (add_alarm_in_us(_asyncDelayUs, asyncAlarm, this, true) < 0)
+			{
+				_asyncBusy = false;
+				printf("Error: setSegments 1: No free alarm, frame dropped.\n");
+			}
+		}
+		restore_interrupts(status);
+		return;
+	}
 
-	// Write Command 3 + brightness
-	CommStart();
-	writeByte(_TM1637_COMMAND_3 + (_brightness & 0x0F));
-	CommStop();
+	// Write Command 1, if changed. The cache is only updated if the frame was acknowledged,
+	// a NACK has already cleared it in writeFrame.
+	if (_lastDataCommand != _TM1637_COMMAND_1)
+	{
+		uint32_t failures = _ackFailures;
+		frame[0] = _TM1637_COMMAND_1;
+		writeFrame(frame, 1);
+		if (_ackFailures == failures) _lastDataCommand = _TM1637_COMMAND_1;
+	}
+
+	// Write Command 2 + first grid address, then the whole shadow frame
+	frame[0] = _TM1637_COMMAND_2;
+	memcpy(&frame[1], _frame, grids);
+	writeFrame(frame, grids + 1);
+
+	// Write Command 3 + brightness, if changed
+	uint8_t control = _TM1637_COMMAND_3 + (_brightness & 0x0F);
+	if (_lastDisplayControl != control)
+	{
+		uint32_t failures = _ackFailures;
+		frame[0] = control;
+		writeFrame(frame, 1);
+		if (_ackFailures == failures) _lastDisplayControl = control;
+	}
+}
+
+/*!
+	@brief Number of grid addresses used by the display
+	@return highest grid address in the digit map + 1
+*/
+uint8_t TM1637plus_model4::gridCount(void) const
+{
+	uint8_t grids = 0;
+	for (uint8_t i = 0; i < _DisplaySize; i++)
+	{
+		if (_digitMap[i] >= grids) grids = _digitMap[i] + 1;
+	}
+	return grids;
+}
+
+/*!
+	@brief Set deferred mode for display writes
+	@param deferred true , setSegments and the Display methods only update the shadow frame,
+		nothing is sent. Set by TM1637Group::addModule, the group sends the frames.
+		false (default), every call is sent to the display.
+	@note Private, only TM1637Group flushes the shadow frame of a deferred module.
+*/
+void TM1637plus_model4::setDeferredMode(bool deferred)
+{
+	_deferredMode = deferred;
+}
+
+/*!
+	@brief Get deferred mode for display writes
+	@return true deferred mode on
+*/
+bool TM1637plus_model4::getDeferredMode(void) const
+{
+	return _deferredMode;
+}
+
+/*!
+	@brief Forget the cached data command and display control state
+	@details The next setSegments call sends all three frames again.
+		Use after a bus glitch, or if the module may have been power cycled.
+		Called by displayBegin, and whenever a byte is not acknowledged.
+*/
+void TM1637plus_model4::forceResync(void)
+{
+	_lastDataCommand = -1;
+	_lastDisplayControl = -1;
 }
 
 
@@ -96,7 +225,7 @@ void TM1637plus_model4::setSegments(const uint8_t segments[], uint8_t length, ui
 	@param length The number of digits to set. The user must ensure that the number to be shown
 			fits to the number of digits requested (for example, if two digits are to be displayed,
 			the number must be between 0 to 99)
-	@param position The position most significant digit (0 - leftmost, 3 - rightmost)
+	@param position The position most significant digit (0 - leftmost, display size - 1 rightmost)
 */
 void TM1637plus_model4::DisplayDecimal(int number,  bool leading_zero ,uint8_t length, uint8_t position)
 {
@@ -118,7 +247,7 @@ void TM1637plus_model4::DisplayDecimal(int number,  bool leading_zero ,uint8_t l
 	@param length The number of digits to set. The user must ensure that the number to be shown
 		  fits to the number of digits requested (for example, if two digits are to be displayed,
 		  the number must be between 0 to 99)
-	@param position The position least significant digit (0 - leftmost, 3 - rightmost)
+	@param position The position least significant digit (0 - leftmost, display size - 1 rightmost)
 */
 void TM1637plus_model4::DisplayDecimalwDot(int number, uint8_t dots,  bool leading_zero ,uint8_t length, uint8_t position)
 {
@@ -169,7 +298,7 @@ void TM1637plus_model4::DisplayDecimalwDot(int number, uint8_t dots,  bool leadi
 		  those digits actually being update (that is, no more than len digits)
 	@param length The number of digits to set. The user must ensure that the number to be shown
 		  fits to the number of digits requested
-	@param position The position most significant digit (0 - leftmost, 3 - rightmost)
+	@param position The position most significant digit (0 - leftmost, display size - 1 rightmost)
 	@return Zero for success , -2 for nullptr, -3 input string size not equal to specified length.
 */
 int TM1637plus_model4::DisplayString(const char* numStr, uint8_t dots, uint8_t length, uint8_t position)
@@ -230,6 +359,11 @@ unsigned char TM1637plus_model4::encodeCharacter(unsigned char digit)
 */
 void TM1637plus_model4::displayClose(void)
 {
+	waitIdle();
+	if (isPIOTransport())
+	{
+		PIOClose();
+	}
 	gpio_set_dir(_CLOCK_IO, GPIO_IN);
 	gpio_set_dir(_DATA_IO, GPIO_IN);
 	gpio_deinit(_DATA_IO);
@@ -238,12 +372,618 @@ void TM1637plus_model4::displayClose(void)
 
 
 /*!
-	@brief Sets the delay, in microseconds, between bit transition on the serial
-		bus connected to the display
+	@brief Set the delay between bit transitions on the serial bus
+	@param delayNs delay in nanoseconds, replaces the microsecond delay set in constructor
+*/
+void TM1637plus_model4::setBitDelayNs(uint32_t delayNs)
+{
+	_BitDelay.setDelayNs(delayNs);
+}
+
+/*!
+	@brief Get the delay between bit transitions on the serial bus
+	@return delay in nanoseconds
+*/
+uint32_t TM1637plus_model4::getBitDelayNs(void) const
+{
+	return _BitDelay.getDelayNs();
+}
+
+/*!
+	@brief Set asynchronous mode for the GPIO transport
+	@param async true , setSegments and the Display methods queue the frame and return,
+		a hardware alarm interrupt then steps through the bus one edge per interrupt.
+		false (default) , methods block until the frame is sent.
+	@note Only one frame waits behind the one being sent, a newer frame replaces it (latest wins).
+		Not used by the PIO transport, which is already non-blocking.
+		Turning asynchronous mode off waits for the transmitter to finish.
+*/
+void TM1637plus_model4::setAsyncMode(bool async)
+{
+	if (async == false) waitIdle();
+	_asyncMode = async;
+}
+
+/*!
+	@brief Get asynchronous mode
+	@return true asynchronous mode on
+*/
+bool TM1637plus_model4::getAsyncMode(void) const
+{
+	return _asyncMode;
+}
+
+/*!
+	@brief Is the asynchronous transmitter sending a frame
+	@return true busy, false idle
+*/
+bool TM1637plus_model4::isBusy(void) const
+{
+	return _asyncBusy;
+}
+
+/*!
+	@brief Block until the asynchronous transmitter is idle
+*/
+void TM1637plus_model4::waitIdle(void)
+{
+	while (_asyncBusy == true)
+	{
+		tight_loop_contents();
+	}
+}
+
+/*!
+	@brief Set the function called when the asynchronous transmitter goes idle
+	@param callback function, called from the alarm interrupt, nullptr for none
+	@param context argument passed to callback
+*/
+void TM1637plus_model4::setCompletionCallback(void (*callback)(void *), void *context)
+{
+	uint32_t status = save_and_disable_interrupts();
+	_asyncCallback = callback;
+	_asyncCallbackContext = context;
+	restore_interrupts(status);
+}
+
+/*!
+	@brief Move the mailbox frame into the transmitter, with the command frames it needs.
+	@note Called with interrupts disabled or from the alarm interrupt.
+		The data command and display control frames are checked against the cache here,
+		the cache is updated as each frame completes without a NACK.
+*/
+void TM1637plus_model4::asyncLoadJob(void)
+{
+	uint8_t control = _TM1637_COMMAND_3 + (_brightness & 0x0F);
+	_txFrameCount = 0;
+	if (_lastDataCommand != _TM1637_COMMAND_1)
+	{
+		_txFrames[_txFrameCount][0] = _TM1637_COMMAND_1;
+		_txLengths[_txFrameCount++] = 1;
+	}
+	memcpy(_txFrames[_txFrameCount], _mailbox, _mailboxLength);
+	_txLengths[_txFrameCount++] = _mailboxLength;
+	if (_lastDisplayControl != control)
+	{
+		_txFrames[_txFrameCount][0] = control;
+		_txLengths[_txFrameCount++] = 1;
+	}
+	_mailboxFull = false;
+	_txFrame = 0;
+	_txStep = StepStart;
+}
+
+/*!
+	@brief Alarm interrupt handler of the asynchronous transmitter
+	@param id alarm id, unused
+	@param userData the TM1637plus_model4 instance
+	@return microseconds to the next edge, 0 when idle
+*/
+int64_t TM1637plus_model4::asyncAlarm(alarm_id_t id, void *userData)
+{
+	(void)id;
+	return static_cast<TM1637plus_model4 *>(userData)->asyncStep();
+}
+
+/*!
+	@brief Drive one bus edge of the asynchronous transmitter
+	@return microseconds to the next edge, 0 when idle
+	@details Same edges and order as CommStart, writeByte and CommStop.
+*/
+int64_t TM1637plus_model4::asyncStep(void)
+{
+	const uint8_t *frame = _txFrames[_txFrame];
+	switch (_txStep)
+	{
+		case StepStart:
+			gpio_set_dir(_DATA_IO, GPIO_OUT);
+			_txNack = false;
+			_txByte = 0;
+			_txBit = 0;
+			_txStep = StepClockLow;
+			break;
+		case StepClockLow:
+			gpio_set_dir(_CLOCK_IO, GPIO_OUT);
+			_txStep = StepData;
+			break;
+		case StepData:
+			gpio_set_dir(_DATA_IO, (frame[_txByte] >> _txBit) & 0x01 ? GPIO_IN : GPIO_OUT);
+			_txStep = StepClockHigh;
+			break;
+		case StepClockHigh:
+			gpio_set_dir(_CLOCK_IO, GPIO_IN);
+			_txStep = (++_txBit < 8) ? StepClockLow : StepAckClockLow;
+			break;
+		case StepAckClockLow:
+			gpio_set_dir(_CLOCK_IO, GPIO_OUT);
+			gpio_set_dir(_DATA_IO, GPIO_IN);
+			_txStep = StepAckClockHigh;
+			break;
+		case StepAckClockHigh:
+			gpio_set_dir(_CLOCK_IO, GPIO_IN);
+			_txStep = StepAckRead;
+			break;
+		case StepAckRead:
+			if (gpio_get(_DATA_IO) == 0)
+			{
+				gpio_set_dir(_DATA_IO, GPIO_OUT);
+			} else
+			{
+				_ackFailures++;
+				_txNack = true;
+				forceResync();
+			}
+			_txStep = StepAckEnd;
+			break;
+		case StepAckEnd:
+			gpio_set_dir(_CLOCK_IO, GPIO_OUT);
+			_txBit = 0;
+			_txStep = (++_txByte < _txLengths[_txFrame]) ? StepClockLow : StepStopData;
+			break;
+		case StepStopData:
+			gpio_set_dir(_DATA_IO, GPIO_OUT);
+			_txStep = StepStopClock;
+			break;
+		case StepStopClock:
+			gpio_set_dir(_CLOCK_IO, GPIO_IN);
+			_txStep = StepStopRelease;
+			break;
+		case StepStopRelease:
+			gpio_set_dir(_DATA_IO, GPIO_IN);
+			// frame complete, update the command cache if every byte was acknowledged
+			if (_txNack == false)
+			{
+				if (frame[0] == _TM1637_COMMAND_1)
+					_lastDataCommand = _TM1637_COMMAND_1;
+				else if ((frame[0] & 0xF0) == _TM1637_COMMAND_3)
+					_lastDisplayControl = frame[0];
+			}
+			_txStep = StepStart;
+			if (++_txFrame < _txFrameCount) break;
+			if (_mailboxFull == true)
+			{
+				asyncLoadJob();
+				break;
+			}
+			_asyncBusy = false;
+			if (_asyncCallback != nullptr) _asyncCallback(_asyncCallbackContext);
+			busRelease();
+			return 0;
+	}
+	return _asyncDelayUs;
+}
+
+/*!
+	@brief Measure the bus and pick the fastest reliable bit delay
+	@param margin percentage added to the fastest delay that passed, default 50
+	@return Zero for success , -2 PIO transport in use, -3 a line did not rise (no pull-up or shorted),
+		-4 no delay passed the ACK test, the previous delay is kept
+	@details
+		-# Rise time : each line is pulled low then released, and the CPU cycles until it
+		reads high are counted with SysTick. The slowest of several samples on CLK and DIO is kept.
+		-# ACK test : starting from the current delay, the delay is halved while every one of
+		a batch of test frames (data command, address command, neither changes the display)
+		is acknowledged, down to the floor : half the period of the rated 250kHz CLK (2uS)
+		plus the rise time. An ACK only shows the chip saw the 9th clock, not that the data
+		bits were latched, so the search never goes past the rated rate.
+		-# The last delay that passed plus margin is applied and stored,
+		see getCalibratedDelayNs / setCalibratedDelayNs to skip calibration at startup.
+	@note GPIO transport only, blocks for the duration. Call after displayBegin.
+*/
+int TM1637plus_model4::calibrate(uint8_t margin)
+{
+	if (isPIOTransport())
+	{
+		printf("Error: calibrate 1: PIO transport runs at a fixed rate.\n");
+		return -2;
+	}
+	waitIdle();
+	_busActive = true;
+
+	// Rise time, SysTick counts CPU cycles down from 0xFFFFFF
+	uint32_t csr = systick_hw->csr;
+	uint32_t rvr = systick_hw->rvr;
+	systick_hw->rvr = 0x00FFFFFF;
+	systick_hw->cvr = 0;
+	systick_hw->csr = 0x05; // enable, processor clock
+	_riseTimeNs = 0;
+	for (uint8_t i = 0; i < _TM1637_CAL_SAMPLES; i++)
+	{
+		uint32_t clockNs = measureRiseNs(_CLOCK_IO);
+		uint32_t dataNs = measureRiseNs(_DATA_IO);
+		if (clockNs > _riseTimeNs) _riseTimeNs = clockNs;
+		if (dataNs > _riseTimeNs) _riseTimeNs = dataNs;
+	}
+	systick_hw->csr = csr;
+	systick_hw->rvr = rvr;
+	if (_riseTimeNs == UINT32_MAX)
+	{
+		printf("Error: calibrate 2: CLK or DIO did not rise, check pull-ups.\n");
+		busRelease();
+		return -3;
+	}
+
+	// ACK test at decreasing delays
+	uint32_t previousNs = _BitDelay.getDelayNs();
+	uint32_t floorNs = _TM1637_MIN_DELAY_NS + _riseTimeNs;
+	uint32_t delayNs = (previousNs > floorNs) ? previousNs : floorNs;
+	uint32_t passNs = 0;
+	while (true)
+	{
+		_BitDelay.setDelayNs(delayNs);
+		if (!ackTest()) break;
+		passNs = delayNs;
+		if (delayNs == floorNs) break;
+		delayNs = (delayNs / 2 > floorNs) ? delayNs / 2 : floorNs;
+	}
+	forceResync();
+	if (passNs == 0)
+	{
+		_BitDelay.setDelayNs(previousNs);
+		printf("Error: calibrate 3: No bit delay gave reliable ACKs.\n");
+		busRelease();
+		return -4;
+	}
+	_calibratedDelayNs = passNs + (uint32_t)(((uint64_t)passNs * margin) / 100);
+	_BitDelay.setDelayNs(_calibratedDelayNs);
+	busRelease();
+	return 0;
+}
+
+/*!
+	@brief Get the slowest rise time measured by calibrate
+	@return nanoseconds, 0 if not calibrated
+*/
+uint32_t TM1637plus_model4::getRiseTimeNs(void) const
+{
+	return _riseTimeNs;
+}
+
+/*!
+	@brief Get the bit delay picked by calibrate
+	@return nanoseconds, 0 if not calibrated
+	@note Store this value to restore it with setCalibratedDelayNs at the next startup.
+*/
+uint32_t TM1637plus_model4::getCalibratedDelayNs(void) const
+{
+	return _calibratedDelayNs;
+}
+
+/*!
+	@brief Apply a bit delay saved from an earlier calibrate, skipping calibration
+	@param delayNs nanoseconds, from getCalibratedDelayNs
+*/
+void TM1637plus_model4::setCalibratedDelayNs(uint32_t delayNs)
+{
+	_calibratedDelayNs = delayNs;
+	_BitDelay.setDelayNs(delayNs);
+}
+
+/*!
+	@brief Measure the rise time of one open drain line
+	@param gpio CLK or DIO GPIO
+	@return nanoseconds from release to reading high, UINT32_MAX if it did not rise within 50mS
+	@note SysTick must be running from the processor clock. Interrupts are off while timing.
+		The timeout is capped inside the 24 bit SysTick range, under 50mS above 335MHz,
+		else the elapsed count would wrap before reaching it and the loop never end.
+*/
+uint32_t TM1637plus_model4::measureRiseNs(uint8_t gpio)
+{
+	static constexpr uint32_t timeoutMax = 0x00FF0000; // SysTick range less a margin for the loop time
+	uint32_t sysHz = clock_get_hz(clk_sys);
+	uint32_t timeout = sysHz / 20;
+	if (timeout > timeoutMax) timeout = timeoutMax;
+	gpio_set_dir(gpio, GPIO_OUT);
+	busy_wait_us_32(10);
+	uint32_t status = save_and_disable_interrupts();
+	uint32_t start = systick_hw->cvr;
+	gpio_set_dir(gpio, GPIO_IN);
+	uint32_t cycles = 0;
+	while (!gpio_get(gpio))
+	{
+		cycles = (start - systick_hw->cvr) & 0x00FFFFFF;
+		if (cycles > timeout) break;
+	}
+	restore_interrupts(status);
+	if (cycles > timeout) return UINT32_MAX;
+	return (uint32_t)(((uint64_t)cycles * 1000000000ULL) / sysHz);
+}
+
+/*!
+	@brief Send a batch of test frames at the current bit delay
+	@return true every byte acknowledged
+	@note Data command and bare address command frames, the display RAM is not changed.
+*/
+bool TM1637plus_model4::ackTest(void)
+{
+	for (uint8_t i = 0; i < _TM1637_CAL_FRAMES; i++)
+	{
+		CommStart();
+		bool nack = writeByte(_TM1637_COMMAND_1);
+		CommStop();
+		CommStart();
+		nack = writeByte(_TM1637_COMMAND_2) || nack;
+		CommStop();
+		if (nack) return false;
+	}
+	return true;
+}
+
+/*!
+	@brief Read the key scan byte from the TM1637
+	@return raw scan code, K1 row 0xF7-0xF0 (SG1-SG8), K2 row 0xEF-0xE8, TM1637_NO_KEY if none
+	@details Sends the read command, releases DIO and clocks in one byte LSB first,
+		the TM1637 only reports one key at a time.
+		Waits for any asynchronous or PIO transfer to finish first.
+		With the PIO transport the pins are handed back to SIO for the read.
+*/
+uint8_t TM1637plus_model4::readKeyCode(void)
+{
+	waitIdle();
+	bool pio = isPIOTransport();
+	if (pio)
+	{
+		PIOWaitIdle();
+		gpio_put(_CLOCK_IO, false);
+		gpio_put(_DATA_IO, false);
+		gpio_set_function(_CLOCK_IO, GPIO_FUNC_SIO);
+		gpio_set_function(_DATA_IO, GPIO_FUNC_SIO);
+		gpio_set_dir(_CLOCK_IO, GPIO_IN);
+		gpio_set_dir(_DATA_IO, GPIO_IN);
+	}
+	_busActive = true;
+	CommStart();
+	if (writeByte(_TM1637_COMMAND_READ) != 0)
+	{
+		_ackFailures++;
+		forceResync();
+	}
+	uint8_t code = readByte();
+	CommStop();
+	if (pio)
+	{
+		pio_gpio_init(_pio, _CLOCK_IO);
+		pio_gpio_init(_pio, _DATA_IO);
+	}
+	busRelease();
+	return code;
+}
+
+/*!
+	@brief Read the key pressed
+	@return key 0-15, K1 SG1-SG8 = 0-7, K2 SG1-SG8 = 8-15, TM1637_NO_KEY if none
+*/
+uint8_t TM1637plus_model4::readKey(void)
+{
+	uint8_t code = readKeyCode();
+	if (code == TM1637_NO_KEY) return TM1637_NO_KEY;
+	return ((code & 0x08) ? 8 : 0) + (7 - (code & 0x07));
+}
+
+/*!
+	@brief Mark the end of a bus transfer, take any key scan deferred during it.
+*/
+void TM1637plus_model4::busRelease(void)
+{
+	_busActive = false;
+	if (_scanPending == true)
+	{
+		_scanPending = false;
+		if (_scanHook != nullptr) _scanHook(_scanHookContext);
+	}
+}
+
+/*!
+	@brief Read the key matrix for the key scanner, unless a transfer is in progress.
+	@param keys set to one bit per key, 1 = pressed
+	@return true keys read, false bus busy and the scan is deferred to the end of the transfer
+*/
+bool TM1637plus_model4::scanKeys(uint16_t &keys)
+{
+	if (_busActive == true || _asyncBusy == true)
+	{
+		_scanPending = true;
+		return false;
+	}
+	uint8_t key = readKey();
+	keys = (key == TM1637_NO_KEY) ? 0 : (1 << key);
+	return true;
+}
+
+/*!
+	@brief Is the PIO bus engine driving the display
+	@return true PIO transport in use, false bit-banged GPIO
+*/
+bool TM1637plus_model4::isPIOTransport(void) const
+{
+	return (_pio != nullptr && _pioSM >= 0);
+}
+
+/*!
+	@brief Get the number of bytes the TM1637 did not acknowledge
+	@return count since displayBegin or the last clearAckFailures
+	@note With the PIO transport the ACK results of frames still in flight are
+		not yet counted, and results are lost if more than four frames are
+		queued between calls to a display method or this one.
+*/
+uint32_t TM1637plus_model4::getAckFailures(void)
+{
+	drainAcks();
+	return _ackFailures;
+}
+
+/*!
+	@brief Reset the ACK failure count to zero
+*/
+void TM1637plus_model4::clearAckFailures(void)
+{
+	drainAcks();
+	_ackFailures = 0;
+}
+
+/*!
+	@brief Send one frame, start condition, bytes and stop condition
+	@param data pointer to the bytes to send, first byte is the command or address
+	@param length number of bytes in frame 1-7
+	@note With the PIO transport the frame is packed 4 bytes per TX FIFO word behind a
+		length byte, so a 7 byte frame is 2 words and a whole display update fits in the
+		4 word FIFO. The call returns once the last word is queued, blocking only while the
+		FIFO is full. The ACK results are collected by the next call.
+*/
+void TM1637plus_model4::writeFrame(const uint8_t *data, uint8_t length)
+{
+	if (length == 0) return;
+	_busActive = true;
+	if (isPIOTransport())
+	{
+		drainAcks();
+		// length byte then the inverted bytes, 4 per FIFO word LSB first, see tm1637.pio
+		uint32_t word = (uint32_t)(length - 1);
+		uint8_t shift = 8;
+		for (uint8_t i = 0; i < length; i++)
+		{
+			word |= (uint32_t)(uint8_t)~data[i] << shift;
+			shift += 8;
+			if (shift == 32)
+			{
+				pio_sm_put_blocking(_pio, _pioSM, word);
+				word = 0;
+				shift = 0;
+			}
+		}
+		if (shift != 0)
+		{
+			pio_sm_put_blocking(_pio, _pioSM, word);
+		}
+		busRelease();
+		return;
+	}
+	CommStart();
+	for (uint8_t i = 0; i < length; i++)
+	{
+		if (writeByte(data[i]) != 0)
+		{
+			_ackFailures++;
+			forceResync();
+		}
+	}
+	CommStop();
+	busRelease();
+}
+
+/*!
+	@brief Count the NACK bits of the frames completed by the PIO bus engine
+*/
+void TM1637plus_model4::drainAcks(void)
+{
+	if (!isPIOTransport()) return;
+	while (!pio_sm_is_rx_fifo_empty(_pio, _pioSM))
+	{
+		uint32_t nack = pio_sm_get(_pio, _pioSM);
+		if (nack != 0)
+		{
+			_ackFailures += __builtin_popcount(nack);
+			forceResync();
+		}
+	}
+}
+
+/*!
+	@brief Load the bus engine program, claim a state machine and hand the pins to PIO.
+	@return true success, false no free state machine or instruction memory
+	@note The program is loaded once per PIO block and shared by all instances.
+*/
+bool TM1637plus_model4::PIOBegin(void)
+{
+	uint pioIndex = pio_get_index(_pio);
+	_pioSM = pio_claim_unused_sm(_pio, false);
+	if (_pioSM < 0)
+	{
+		return false;
+	}
+	if (_pioProgramOffset[pioIndex] < 0)
+	{
+		if (!pio_can_add_program(_pio, &tm1637_program))
+		{
+			pio_sm_unclaim(_pio, _pioSM);
+			_pioSM = -1;
+			return false;
+		}
+		_pioProgramOffset[pioIndex] = (int8_t)pio_add_program(_pio, &tm1637_program);
+	}
+	_pioProgramUsers[pioIndex]++;
+
+	// 16 PIO cycles per bit on the bus
+	float clkdiv = (float)clock_get_hz(clk_sys) / (float)(_TM1637_PIO_BUS_HZ * 16);
+	if (clkdiv < 1.0f) clkdiv = 1.0f;
+	tm1637_program_init(_pio, _pioSM, _pioProgramOffset[pioIndex], _CLOCK_IO, _DATA_IO, clkdiv);
+	return true;
+}
+
+/*!
+	@brief Wait for the bus engine to finish, release the state machine and program.
+*/
+void TM1637plus_model4::PIOClose(void)
+{
+	uint pioIndex = pio_get_index(_pio);
+	PIOWaitIdle();
+	drainAcks();
+	pio_sm_set_enabled(_pio, _pioSM, false);
+	pio_sm_unclaim(_pio, _pioSM);
+	_pioSM = -1;
+	if (_pioProgramUsers[pioIndex] > 0 && --_pioProgramUsers[pioIndex] == 0)
+	{
+		pio_remove_program(_pio, &tm1637_program, _pioProgramOffset[pioIndex]);
+		_pioProgramOffset[pioIndex] = -1;
+	}
+	gpio_init(_DATA_IO);
+	gpio_init(_CLOCK_IO);
+}
+
+/*!
+	@brief Block until every queued frame has been clocked out by the state machine.
+*/
+void TM1637plus_model4::PIOWaitIdle(void)
+{
+	uint32_t stallMask = 1u << (PIO_FDEBUG_TXSTALL_LSB + _pioSM);
+	while (!pio_sm_is_tx_fifo_empty(_pio, _pioSM))
+	{
+		drainAcks();
+	}
+	// The engine stalls on the frame header pull once the last frame is complete
+	_pio->fdebug = stallMask;
+	while (!(_pio->fdebug & stallMask))
+	{
+		drainAcks();
+	}
+}
+
+/*!
+	@brief Delay between bit transitions on the serial bus connected to the display
 */
 void TM1637plus_model4::CommBitDelay(void)
 {
-	busy_wait_us(_BitDelayUS);
+	_BitDelay.wait();
 }
 
 /*! 
@@ -251,6 +991,7 @@ void TM1637plus_model4::CommBitDelay(void)
 */
 void TM1637plus_model4::CommStart(void)
 {
+	_BitDelay.update();
 	gpio_set_dir(_DATA_IO, GPIO_OUT);
 	CommBitDelay();
 }
@@ -271,6 +1012,43 @@ void TM1637plus_model4::CommStop(void)
 	CommBitDelay();
 }
 
+/*!
+	@brief Reads a byte from the Display, after the read command
+	@return the byte read, LSB first
+	@note DIO is released for the whole byte, the TM1637 changes it after each
+		falling CLK edge and it is sampled with CLK high. The master ACK holds DIO
+		low for the 9th clock.
+*/
+uint8_t TM1637plus_model4::readByte(void)
+{
+	uint8_t data = 0;
+
+	gpio_set_dir(_DATA_IO, GPIO_IN);
+	for (uint8_t i = 0; i < 8; i++)
+	{
+		// Set clock low
+		gpio_set_dir(_CLOCK_IO, GPIO_OUT);
+		CommBitDelay();
+		CommBitDelay();
+
+		// Set Clock high and sample
+		gpio_set_dir(_CLOCK_IO, GPIO_IN);
+		CommBitDelay();
+		data |= (gpio_get(_DATA_IO) ? 1 : 0) << i;
+	}
+
+	// Master acknowledge
+	gpio_set_dir(_CLOCK_IO, GPIO_OUT);
+	gpio_set_dir(_DATA_IO, GPIO_OUT);
+	CommBitDelay();
+	gpio_set_dir(_CLOCK_IO, GPIO_IN);
+	CommBitDelay();
+	gpio_set_dir(_CLOCK_IO, GPIO_OUT);
+	CommBitDelay();
+
+	return data;
+}
+
 /*! 
 	@brief Writes a byte to the Display
 	@param byte the Byte to write
@@ -0,0 +1,251 @@
+/*!
+	@file     tm1637_group.cpp
+	@author   Gavin Lyons
+	@brief    PICO library source file for several TM1637 modules sharing one CLK line.
+*/
+
+#include <cstring>
+#include "pico/stdlib.h"
+#include "displaylib_LED_PICO/tm1637_group.hpp"
+
+/*!
+	@brief Constructor for class TM1637Group
+	@param clock GPIO CLK pin shared by all modules
+*/
+TM1637Group::TM1637Group(uint8_t clock)
+{
+	_CLOCK_IO = clock;
+}
+
+/*!
+	@brief Add a module to the group
+	@param module a TM1637 object constructed with the group CLK GPIO and its own DIO GPIO
+	@return 0 for success, -2 group full, -3 CLK GPIO does not match or DIO already used,
+		-4 module uses the PIO transport
+	@note The module is put into deferred mode, its display methods update the
+		shadow frame and TM1637Group::flush() writes it out.
+		Do not call displayBegin() on the module, the group sets up the GPIO.
+		The group delay is set to the largest delay of its modules, so the slowest module
+		sets the bus rate. Set the module delays before adding them, setBitDelayNs overrides.
+*/
+int TM1637Group::addModule(TM1637plus_model4 &module)
+{
+	if (_moduleCount >= TM_GROUP_MAX_MODULES)
+	{
+		printf("Error: addModule 1: Group is full, %u modules maximum.\n", TM_GROUP_MAX_MODULES);
+		return -2;
+	}
+	if (module._CLOCK_IO != _CLOCK_IO || (_dataMask & (1u << module._DATA_IO)))
+	{
+		printf("Error: addModule 2: Module CLK GPIO does not match or DIO GPIO already in group.\n");
+		return -3;
+	}
+	if (module._pio != nullptr)
+	{
+		printf("Error: addModule 3: Modules in a group must use GPIO transport.\n");
+		return -4;
+	}
+	uint32_t delayNs = module._BitDelay.getDelayNs();
+	if (_moduleCount == 0 || delayNs > _BitDelay.getDelayNs())
+	{
+		_BitDelay.setDelayNs(delayNs);
+	}
+	module.setDeferredMode(true);
+	module.forceResync();
+	_modules[_moduleCount++] = &module;
+	_dataMask |= (1u << module._DATA_IO);
+	return 0;
+}
+
+/*!
+	@brief Get number of modules in the group
+	@return number of modules 0-8
+*/
+uint8_t TM1637Group::getModuleCount(void) const
+{
+	return _moduleCount;
+}
+
+/*!
+	@brief Begin method , claims CLK and all DIO GPIO, both lines released (open drain).
+	@note Add all modules before calling.
+*/
+void TM1637Group::displayBegin(void)
+{
+	gpio_init(_CLOCK_IO);
+	gpio_init_mask(_dataMask);
+	gpio_set_dir(_CLOCK_IO, GPIO_IN);
+	gpio_set_dir_masked(_dataMask, 0);
+}
+
+/*!
+	@brief Close method , frees CLK and all DIO GPIO.
+*/
+void TM1637Group::displayClose(void)
+{
+	gpio_set_dir(_CLOCK_IO, GPIO_IN);
+	gpio_set_dir_masked(_dataMask, 0);
+	gpio_deinit(_CLOCK_IO);
+	for (uint8_t i = 0; i < _moduleCount; i++)
+	{
+		gpio_deinit(_modules[i]->_DATA_IO);
+	}
+}
+
+/*!
+	@brief Set the delay between bus edges
+	@param delayNs delay in nanoseconds, default 75uS
+	@note addModule sets it to the largest module delay, call after adding the modules.
+*/
+void TM1637Group::setBitDelayNs(uint32_t delayNs)
+{
+	_BitDelay.setDelayNs(delayNs);
+}
+
+/*!
+	@brief Get the delay between bus edges
+	@return delay in nanoseconds
+*/
+uint32_t TM1637Group::getBitDelayNs(void) const
+{
+	return _BitDelay.getDelayNs();
+}
+
+/*!
+	@brief Write the shadow frame of every module to its display
+	@return bit mask of modules (bit n = n-th module added) that did not acknowledge a byte
+	@details Sends the data command and display control frames only if a module needs them,
+		see TM1637plus_model4::setSegments, and the address + data frame always.
+		Each frame goes to all modules at once, each with its own bytes.
+		Every module is marked busy for the whole flush, so a key scan of any of them
+		is deferred until the shared CLK is free.
+*/
+uint8_t TM1637Group::flush(void)
+{
+	uint8_t frames[TM_GROUP_MAX_MODULES][TM_GROUP_FRAME_SIZE] = {{0}};
+	uint8_t nack = 0;
+	bool needData = false;
+	bool needControl = false;
+	uint8_t grids = 0;
+	if (_moduleCount == 0) return 0;
+
+	for (uint8_t i = 0; i < _moduleCount; i++)
+	{
+		TM1637plus_model4 *module = _modules[i];
+		module->_busActive = true;
+		uint8_t control = module->_TM1637_COMMAND_3 + (module->_brightness & 0x0F);
+		if (module->_lastDataCommand != module->_TM1637_COMMAND_1) needData = true;
+		if (module->_lastDisplayControl != control) needControl = true;
+		if (module->gridCount() > grids) grids = module->gridCount();
+	}
+
+	// Data command, same for all
+	if (needData)
+	{
+		for (uint8_t i = 0; i < _moduleCount; i++) frames[i][0] = _modules[i]->_TM1637_COMMAND_1;
+		nack |= writeFrameAll(frames, 1);
+	}
+	// Address + data, each module its own shadow frame
+	for (uint8_t i = 0; i < _moduleCount; i++)
+	{
+		frames[i][0] = _modules[i]->_TM1637_COMMAND_2;
+		memcpy(&frames[i][1], _modules[i]->_frame, grids);
+	}
+	nack |= writeFrameAll(frames, grids + 1);
+	// Display control, each module its own brightness
+	if (needControl)
+	{
+		for (uint8_t i = 0; i < _moduleCount; i++)
+			frames[i][0] = _modules[i]->_TM1637_COMMAND_3 + (_modules[i]->_brightness & 0x0F);
+		nack |= writeFrameAll(frames, 1);
+	}
+
+	for (uint8_t i = 0; i < _moduleCount; i++)
+	{
+		TM1637plus_model4 *module = _modules[i];
+		if (nack & (1 << i))
+		{
+			module->_ackFailures++;
+			module->forceResync();
+		} else
+		{
+			module->_lastDataCommand = module->_TM1637_COMMAND_1;
+			module->_lastDisplayControl = module->_TM1637_COMMAND_3 + (module->_brightness & 0x0F);
+		}
+		module->busRelease();
+	}
+	return nack;
+}
+
+/*!
+	@brief DIO lines to pull low for one bit of every module's frame
+	@param frames one frame per module
+	@param byte byte index in the frames
+	@param bit bit index in the byte, LSB first
+	@return GPIO mask of the DIO lines whose bit is 0
+*/
+uint32_t TM1637Group::lowMask(const uint8_t frames[][TM_GROUP_FRAME_SIZE], uint8_t byte, uint8_t bit) const
+{
+	uint32_t mask = 0;
+	for (uint8_t i = 0; i < _moduleCount; i++)
+	{
+		if (!((frames[i][byte] >> bit) & 0x01)) mask |= (1u << _modules[i]->_DATA_IO);
+	}
+	return mask;
+}
+
+/*!
+	@brief Send one frame to all modules at once, start, bytes with ACK, stop
+	@param frames one frame per module, all the same length
+	@param length bytes in each frame 1-7
+	@return bit mask of modules that did not acknowledge a byte
+	@note Same edges as TM1637plus_model4::CommStart / writeByte / CommStop, open drain,
+		a DIO line is pulled low by making it an output (value 0) and released by
+		making it an input.
+*/
+uint8_t TM1637Group::writeFrameAll(const uint8_t frames[][TM_GROUP_FRAME_SIZE], uint8_t length)
+{
+	uint8_t nack = 0;
+	_BitDelay.update();
+
+	// Start
+	gpio_set_dir_masked(_dataMask, _dataMask);
+	_BitDelay.wait();
+
+	for (uint8_t byte = 0; byte < length; byte++)
+	{
+		for (uint8_t bit = 0; bit < 8; bit++)
+		{
+			gpio_set_dir(_CLOCK_IO, GPIO_OUT);
+			_BitDelay.wait();
+			gpio_set_dir_masked(_dataMask, lowMask(frames, byte, bit));
+			_BitDelay.wait();
+			gpio_set_dir(_CLOCK_IO, GPIO_IN);
+			_BitDelay.wait();
+		}
+		// ACK from every module in one read
+		gpio_set_dir(_CLOCK_IO, GPIO_OUT);
+		gpio_set_dir_masked(_dataMask, 0);
+		_BitDelay.wait();
+		gpio_set_dir(_CLOCK_IO, GPIO_IN);
+		_BitDelay.wait();
+		uint32_t high = gpio_get_all() & _dataMask;
+		gpio_set_dir_masked(_dataMask, ~high);
+		for (uint8_t i = 0; i < _moduleCount; i++)
+		{
+			if (high & (1u << _modules[i]->_DATA_IO)) nack |= (1 << i);
+		}
+		_BitDelay.wait();
+		gpio_set_dir(_CLOCK_IO, GPIO_OUT);
+		_BitDelay.wait();
+	}
+
+	// Stop
+	gpio_set_dir_masked(_dataMask, _dataMask);
+	_BitDelay.wait();
+	gpio_set_dir(_CLOCK_IO, GPIO_IN);
+	_BitDelay.wait();
+	gpio_set_dir_masked(_dataMask, 0);
+	_BitDelay.wait();
+	return nack;
+}
@@ -0,0 +1,50 @@
+/*!
+	@file     tm1637_keyscan.cpp
+	@author   Gavin Lyons
+	@brief    PICO library source file, background key scanner for TM1637 modules.
+*/
+
+#include "pico/stdlib.h"
+#include "displaylib_LED_PICO/tm1637_keyscan.hpp"
+
+/*!
+	@brief Constructor for class TM1637plus_keyscan
+	@param module TM1637 object to scan
+*/
+TM1637plus_keyscan::TM1637plus_keyscan(TM1637plus_model4 &module)
+{
+	_module = &module;
+	_readInInterrupt = false; // a key read takes mS, keep it out of the timer interrupt
+	_module->_scanHook = deferredScan;
+	_module->_scanHookContext = this;
+}
+
+/*!
+	@brief Destructor for class TM1637plus_keyscan, stops scanning
+*/
+TM1637plus_keyscan::~TM1637plus_keyscan()
+{
+	scanEnd();
+	_module->_scanHook = nullptr;
+	_module->_scanHookContext = nullptr;
+}
+
+/*!
+	@brief Read the key matrix unless a display transfer is in progress
+	@param keys set to one bit per key, 1 = pressed
+	@return true sample taken, false deferred until the bus is free
+*/
+bool TM1637plus_keyscan::readKeys(uint16_t &keys)
+{
+	return _module->scanKeys(keys);
+}
+
+/*!
+	@brief Mark the deferred sample due, called by the module when the bus is released
+	@param context the scanner
+	@note May be called from the asynchronous write interrupt, the sample is taken by poll().
+*/
+void TM1637plus_keyscan::deferredScan(void *context)
+{
+	static_cast<TM1637plus_keyscan *>(context)->sampleDue();
+}
@@ -0,0 +1,198 @@
+/*!
+	@file     tm1638plus_bus.cpp
+	@author   Gavin Lyons
+	@brief    PICO library source file for several TM1638 modules sharing one CLK/DIO bus.
+*/
+
+#include <cstring>
+#include "pico/stdlib.h"
+#include "displaylib_LED_PICO/tm1638plus_bus.hpp"
+
+/*!
+	@brief Constructor for class TM1638Bus
+	@param clock  GPIO CLK pin shared by all modules
+	@param data  GPIO DIO pin shared by all modules
+*/
+TM1638Bus::TM1638Bus(uint8_t clock, uint8_t data)
+{
+	_CLOCK_IO = clock;
+	_DATA_IO = data;
+}
+
+/*!
+	@brief Add a module to the bus
+	@param module a TM1638 model 1, 2 or 3 object constructed with the bus CLK and DIO GPIO
+	@return 0 for success, -2 bus full, -3 CLK or DIO GPIO does not match the bus,
+		-4 module uses the PIO transport
+	@note The module is put into deferred mode, its display methods update the
+		shadow display RAM and TM1638Bus::flush() writes it out.
+		Do not call displayBegin() on the module, the bus sets up the GPIO.
+*/
+int TM1638Bus::addModule(TM1638plus_common &module)
+{
+	if (_moduleCount >= TM_BUS_MAX_MODULES)
+	{
+		printf("Error: addModule 1: Bus is full, %u modules maximum.\n", TM_BUS_MAX_MODULES);
+		return -2;
+	}
+	if (module._CLOCK_IO != _CLOCK_IO || module._DATA_IO != _DATA_IO)
+	{
+		printf("Error: addModule 2: Module CLK/DIO GPIO do not match the bus.\n");
+		return -3;
+	}
+	if (module._pio != nullptr)
+	{
+		printf("Error: addModule 3: Modules on a shared bus must use GPIO transport.\n");
+		return -4;
+	}
+	module.setDeferredMode(true);
+	module._bus = this;
+	_modules[_moduleCount++] = &module;
+	_strobeMask |= (1u << module._STROBE_IO);
+	return 0;
+}
+
+/*!
+	@brief Get number of modules on the bus
+	@return number of modules 0-8
+*/
+uint8_t TM1638Bus::getModuleCount(void) const
+{
+	return _moduleCount;
+}
+
+/*!
+	@brief Begin method , sets pin modes for the bus and all strobes, activates and clears all modules.
+	@note Add all modules before calling.
+*/
+void TM1638Bus::displayBegin(void)
+{
+	if (_moduleCount == 0) return;
+	gpio_init(_CLOCK_IO);
+	gpio_init(_DATA_IO);
+	gpio_init_mask(_strobeMask);
+	gpio_put_masked(_strobeMask, _strobeMask); // all strobes idle high
+	gpio_set_dir(_CLOCK_IO, GPIO_OUT);
+	gpio_set_dir(_DATA_IO, GPIO_OUT);
+	gpio_set_dir_out_masked(_strobeMask);
+	sendCommand(TM1638plus_common::TM_ACTIVATE);
+	brightness(TM1638plus_common::TM_DEFAULT_BRIGHTNESS);
+	reset();
+}
+
+/*!
+	@brief Close method , clears all modules and deinits the bus GPIO.
+*/
+void TM1638Bus::displayClose(void)
+{
+	if (_moduleCount == 0) return;
+	reset();
+	busy_wait_ms(50);
+	gpio_put_masked(_strobeMask, 0);
+	gpio_put(_DATA_IO, false);
+	gpio_put(_CLOCK_IO, false);
+	busy_wait_ms(50);
+	for (uint8_t i = 0; i < _moduleCount; i++)
+	{
+		gpio_deinit(_modules[i]->_STROBE_IO);
+	}
+	gpio_deinit(_DATA_IO);
+	gpio_deinit(_CLOCK_IO);
+}
+
+/*!
+	@brief Reset / clear all modules in one broadcast, and their shadow display RAM.
+*/
+void TM1638Bus::reset(void)
+{
+	uint8_t frame[TM1638plus_common::TM_RAM_SIZE + 1] = {TM1638plus_common::TM_SEG_ADR};
+	lockAll();
+	sendCommand(TM1638plus_common::TM_WRITE_INC);
+	sendFrameAll(frame, sizeof(frame));
+	for (uint8_t i = 0; i < _moduleCount; i++)
+	{
+		TM1638plus_common *module = _modules[i];
+		memset(module->_displayRAM, 0, sizeof(module->_displayRAM));
+		memset(module->_chipRAM, 0, sizeof(module->_chipRAM));
+		module->_dirtyMask = 0;
+	}
+	unlockAll();
+}
+
+/*!
+	@brief Set the brightness of all modules in one broadcast
+	@param brightness byte with value 0 to 7
+*/
+void TM1638Bus::brightness(uint8_t brightness)
+{
+	sendCommand(TM1638plus_common::TM_BRIGHT_ADR + (TM1638plus_common::TM_BRIGHT_MASK & brightness));
+}
+
+/*!
+	@brief Send a command byte to all modules at once
+	@param value command byte
+*/
+void TM1638Bus::sendCommand(uint8_t value)
+{
+	sendFrameAll(&value, 1);
+}
+
+/*!
+	@brief Flush every module's shadow display RAM, back to back in one pass
+	@param fullImage default false, if true all 16 addresses of every module are rewritten
+	@return total number of bus bytes emitted
+*/
+uint16_t TM1638Bus::flush(bool fullImage)
+{
+	uint16_t busBytes = 0;
+	lockAll();
+	for (uint8_t i = 0; i < _moduleCount; i++)
+	{
+		busBytes += _modules[i]->flush(fullImage);
+	}
+	unlockAll();
+	return busBytes;
+}
+
+/*!
+	@brief Send a frame with every module strobe asserted
+	@param data pointer to bytes to send
+	@param length number of bytes
+*/
+void TM1638Bus::sendFrameAll(const uint8_t *data, uint8_t length)
+{
+	if (_moduleCount == 0) return;
+	TM1638plus_common *shifter = _modules[0]; // any module can shift, they share CLK & DIO
+	lockAll();
+	shifter->_busDelay.update();
+	gpio_put_masked(_strobeMask, 0);
+	for (uint8_t i = 0; i < length; i++)
+	{
+		shifter->sendData(data[i]);
+	}
+	gpio_put_masked(_strobeMask, _strobeMask);
+	unlockAll();
+}
+
+/*!
+	@brief Mark the shared bus busy on every module, key scans are deferred
+	@note Also called by the busAcquire of a module on the bus.
+*/
+void TM1638Bus::lockAll(void)
+{
+	for (uint8_t i = 0; i < _moduleCount; i++)
+	{
+		_modules[i]->busLock();
+	}
+}
+
+/*!
+	@brief Release the shared bus on every module, deferred key scans run now
+*/
+void TM1638Bus::unlockAll(void)
+{
+	for (uint8_t i = 0; i < _moduleCount; i++)
+	{
+		_modules[i]->busUnlock();
+	}
+}
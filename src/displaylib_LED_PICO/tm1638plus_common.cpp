@@ -4,33 +4,55 @@
 	@brief     cpp  file for common data and functions between model 1 and 2 classes
 */
 
+#include <cstring>
 #include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/sio.h"
 #include "displaylib_LED_PICO/tm1638plus_common.hpp"
+#include "displaylib_LED_PICO/tm1638plus_bus.hpp"
+#include "tm1638plus.pio.h"
+
+int8_t TM1638plus_common::_pioProgramOffset[2] = {-1, -1};
+uint8_t TM1638plus_common::_pioProgramUsers[2] = {0, 0};
 
 /*!
 	@brief Constructor for class TM1638plus_common
 	@param strobe  GPIO STB pin
 	@param clock  GPIO CLK pin
 	@param data  GPIO DIO pin
+	@param pio PIO instance (pio0 or pio1) to run the bus engine on,
+		default nullptr , bit-banged GPIO is used.
 */
-TM1638plus_common::TM1638plus_common(uint8_t strobe, uint8_t clock, uint8_t data)
+TM1638plus_common::TM1638plus_common(uint8_t strobe, uint8_t clock, uint8_t data, PIO pio)
 {
 	_STROBE_IO = strobe;
 	_DATA_IO = data;
 	_CLOCK_IO = clock;
+	_pio = pio;
 }
 
 /*!
 	@brief Begin method , sets pin modes and activate display.
+	@note If the PIO transport cannot be started (no free state machine or
+		instruction memory) the driver falls back to bit-banged GPIO.
 */
 void TM1638plus_common::displayBegin()
 {
-	gpio_init(_STROBE_IO);
-	gpio_init(_DATA_IO);
-	gpio_init(_CLOCK_IO);
-	gpio_set_dir(_STROBE_IO, GPIO_OUT);
-	gpio_set_dir(_DATA_IO, GPIO_OUT);
-	gpio_set_dir(_CLOCK_IO, GPIO_OUT);
+	if (_pio != nullptr && PIOBegin() == false)
+	{
+		printf("Error: displayBegin 1: PIO transport unavailable, using GPIO.\n");
+		_pio = nullptr;
+	}
+	if (_pio == nullptr)
+	{
+		gpio_init(_STROBE_IO);
+		gpio_init(_DATA_IO);
+		gpio_init(_CLOCK_IO);
+		gpio_set_dir(_STROBE_IO, GPIO_OUT);
+		gpio_set_dir(_DATA_IO, GPIO_OUT);
+		gpio_set_dir(_CLOCK_IO, GPIO_OUT);
+	}
+	_totalBusBytes = 0;
 	sendCommand(TM_ACTIVATE);
 	brightness(TM_DEFAULT_BRIGHTNESS);
 	reset();
@@ -43,6 +65,10 @@ void TM1638plus_common::displayClose()
 {
 	reset();
 	busy_wait_ms(50);
+	if (_pio != nullptr)
+	{
+		PIOClose();
+	}
 	gpio_put(_STROBE_IO, false);
 	gpio_put(_DATA_IO, false);
 	gpio_put(_CLOCK_IO, false);
@@ -52,15 +78,40 @@ void TM1638plus_common::displayClose()
 	gpio_deinit(_CLOCK_IO);
 }
 
+/*!
+	@brief Is the PIO bus engine driving the display
+	@return true PIO transport in use, false bit-banged GPIO
+*/
+bool TM1638plus_common::isPIOTransport(void) const
+{
+	return (_pio != nullptr && _pioSM >= 0);
+}
+
+/*!
+	@brief Set the half bit delay of the bit-banged GPIO bus
+	@param delayNs delay in nanoseconds, default 500nS. Not used by the PIO transport.
+*/
+void TM1638plus_common::setBusDelayNs(uint32_t delayNs)
+{
+	_busDelay.setDelayNs(delayNs);
+}
+
+/*!
+	@brief Get the half bit delay of the bit-banged GPIO bus
+	@return delay in nanoseconds
+*/
+uint32_t TM1638plus_common::getBusDelayNs(void) const
+{
+	return _busDelay.getDelayNs();
+}
+
 /*!
 	@brief Send command to display
 	@param value command byte to send
 */
 void TM1638plus_common::sendCommand(uint8_t value)
 {
-	gpio_put(_STROBE_IO, false);
-	sendData(value);
-	gpio_put(_STROBE_IO, true);
+	sendFrame(&value, 1);
 }
 
 /*!
@@ -72,20 +123,149 @@ void TM1638plus_common::sendData(uint8_t data)
 	HighFreqshiftOut(_DATA_IO, _CLOCK_IO, data);
 }
 
+/*!
+	@brief Send a frame of bytes to the display, STB is held low for the whole frame.
+	@param data pointer to the bytes to send, first byte is the command or address
+	@param length number of bytes in frame 1-255
+*/
+void TM1638plus_common::sendFrame(const uint8_t *data, uint8_t length)
+{
+	if (length == 0) return;
+	if (isPIOTransport())
+	{
+		// header word then one FIFO word per byte, see tm1638plus.pio
+		pio_sm_put_blocking(_pio, _pioSM, (uint32_t)(length - 1));
+		for (uint8_t i = 0; i < length; i++)
+		{
+			pio_sm_put_blocking(_pio, _pioSM, data[i]);
+		}
+		return;
+	}
+	_busDelay.update();
+	gpio_put(_STROBE_IO, false);
+	for (uint8_t i = 0; i < length; i++)
+	{
+		sendData(data[i]);
+	}
+	gpio_put(_STROBE_IO, true);
+}
+
+/*!
+	@brief Send the read key scan command and read back the key scan bytes.
+	@param data pointer to buffer to hold key scan bytes
+	@param length number of bytes to read 1-4
+*/
+void TM1638plus_common::readFrame(uint8_t *data, uint8_t length)
+{
+	if (length == 0) return;
+	busAcquire();
+	if (isPIOTransport())
+	{
+		pio_sm_put_blocking(_pio, _pioSM, ((uint32_t)length << 8));
+		pio_sm_put_blocking(_pio, _pioSM, TM_BUTTONS_MODE);
+		for (uint8_t i = 0; i < length; i++)
+		{
+			data[i] = (uint8_t)(pio_sm_get_blocking(_pio, _pioSM) >> 24);
+		}
+		busRelease();
+		return;
+	}
+	_busDelay.update();
+	gpio_put(_STROBE_IO, false);
+	sendData(TM_BUTTONS_MODE);
+	busy_wait_us(TM_READ_WAIT_US); // Twait, a 1uS wait can end early by up to one timer tick
+	gpio_set_dir(_DATA_IO, GPIO_IN);
+	for (uint8_t i = 0; i < length; i++)
+	{
+		data[i] = HighFreqshiftin(_DATA_IO, _CLOCK_IO);
+	}
+	gpio_set_dir(_DATA_IO, GPIO_OUT);
+	gpio_put(_STROBE_IO, true);
+	busRelease();
+}
+
 /*!
 	@brief Reset / clear  the  display
 	@note The display is cleared by writing zero to all data segment  addresses.
+		The shadow display RAM is cleared as well.
 */
 void TM1638plus_common::reset()
 {
-	sendCommand(TM_WRITE_INC); // set auto increment mode
-	gpio_put(_STROBE_IO, false);
-	sendData(TM_SEG_ADR); // set starting address to
-	for (uint8_t i = 0; i < 16; i++)
+	memset(_displayRAM, 0, sizeof(_displayRAM));
+	flush(true);
+}
+
+/*!
+	@brief Set deferred mode for display writes
+	@param deferred true , display & LED methods only update the shadow display RAM
+		and nothing is sent until flush() is called. false (default), every method
+		call is written to the display immediately.
+	@note Use deferred mode to combine a text update and a LED update into one transaction.
+		Turning deferred mode off does not flush pending changes, call flush().
+*/
+void TM1638plus_common::setDeferredMode(bool deferred)
+{
+	_deferredMode = deferred;
+}
+
+/*!
+	@brief Get deferred mode for display writes
+	@return true deferred mode on, false writes sent immediately
+*/
+bool TM1638plus_common::getDeferredMode(void) const
+{
+	return _deferredMode;
+}
+
+/*!
+	@brief Write the changed part of the shadow display RAM to the display
+	@param fullImage default false, if true all 16 addresses are rewritten.
+	@return Number of bytes put on the bus by this flush, 0 if nothing changed.
+	@details Only addresses that differ from what the chip holds are sent, with the
+		cost model of TM1638plus_core::flushDirty.
+*/
+uint8_t TM1638plus_common::flush(bool fullImage)
+{
+	if (fullImage == true) _dirtyMask = 0xFFFF;
+	if (_dirtyMask == 0)
 	{
-		sendData(0x00);
+		_flushBusBytes = 0;
+		return 0;
 	}
-	gpio_put(_STROBE_IO, true);
+	busAcquire();
+	flushDirty([this](const uint8_t *frame, uint8_t length) { sendFrame(frame, length); });
+	busRelease();
+	return _flushBusBytes;
+}
+
+/*!
+	@brief Get number of bus bytes emitted by the last flush
+	@return bytes, commands + addresses + data, 0 if nothing changed
+*/
+uint8_t TM1638plus_common::getFlushBusBytes(void) const
+{
+	return _flushBusBytes;
+}
+
+/*!
+	@brief Get number of bus bytes emitted by all flushes since displayBegin
+	@return bytes, commands + addresses + data
+*/
+uint32_t TM1638plus_common::getTotalBusBytes(void) const
+{
+	return _totalBusBytes;
+}
+
+/*!
+	@brief Write one byte of display RAM
+	@param address display RAM offset 0x00-0x0F , segments even, LEDs odd
+	@param value data byte
+	@note Updates the shadow display RAM and marks the address dirty if it differs
+		from the chip. Flushed at once unless deferred mode is on.
+*/
+void TM1638plus_common::writeDisplayRAM(uint8_t address, uint8_t value)
+{
+	if (storeDisplayRAM(address, value) == true) flush();
 }
 
 /*!
@@ -96,7 +276,79 @@ void TM1638plus_common::brightness(uint8_t brightness)
 {
 	uint8_t value = 0;
 	value = TM_BRIGHT_ADR + (TM_BRIGHT_MASK & brightness);
+	busAcquire();
 	sendCommand(value);
+	busRelease();
+}
+
+/*!
+	@brief Mark the start of a bus transaction, a key scan arriving now is deferred.
+	@note A module on a TM1638Bus locks every module on the bus, as they share CLK and DIO,
+		so a direct write to one module also defers key scans of the others.
+*/
+void TM1638plus_common::busAcquire(void)
+{
+	if (_bus != nullptr)
+		_bus->lockAll();
+	else
+		busLock();
+}
+
+/*!
+	@brief Mark the end of a bus transaction, take any key scan deferred during it.
+*/
+void TM1638plus_common::busRelease(void)
+{
+	if (_bus != nullptr)
+		_bus->unlockAll();
+	else
+		busUnlock();
+}
+
+/*!
+	@brief Take the bus lock of this module only
+*/
+void TM1638plus_common::busLock(void)
+{
+	_busLock = _busLock + 1;
+}
+
+/*!
+	@brief Release the bus lock of this module only, take any key scan deferred while it was held
+*/
+void TM1638plus_common::busUnlock(void)
+{
+	if (_busLock > 0) _busLock = _busLock - 1;
+	if (_busLock == 0 && _scanPending == true)
+	{
+		_scanPending = false;
+		if (_scanHook != nullptr) _scanHook(_scanHookContext);
+	}
+}
+
+/*!
+	@brief Read the key matrix for the key scanner, unless a transaction is in progress.
+	@param keys set to one bit per key, 1 = pressed
+	@return true keys read, false bus busy and the scan is deferred to busRelease
+*/
+bool TM1638plus_common::scanKeys(uint16_t &keys)
+{
+	if (_busLock != 0)
+	{
+		_scanPending = true;
+		return false;
+	}
+	keys = readKeyMatrix();
+	return true;
+}
+
+/*!
+	@brief Read the key matrix as one bit per key, over-ridden by each model
+	@return key bits, 1 = pressed
+*/
+uint16_t TM1638plus_common::readKeyMatrix(void)
+{
+	return 0;
 }
 
 /*!
@@ -114,10 +366,10 @@ uint8_t TM1638plus_common::HighFreqshiftin(uint8_t dataPin, uint8_t clockPin)
 	{
 
 		gpio_put(clockPin, true);
-		busy_wait_us(_HFIN_DELAY);
+		_busDelay.wait();
 		value |= gpio_get(dataPin) << i;
 		gpio_put(clockPin, false);
-		busy_wait_us(_HFIN_DELAY);
+		_busDelay.wait();
 	}
 	return value;
 }
@@ -127,17 +379,94 @@ uint8_t TM1638plus_common::HighFreqshiftin(uint8_t dataPin, uint8_t clockPin)
 	@param dataPin Tm1638 Data GPIO
 	@param clockPin Tm1638 Clock GPIO
 	@param val The byte of data to shift out
+	@note CLK low and the data bit go out in one masked store,
+		the TM1638 latches DIO on the rising edge of CLK.
 */
 void TM1638plus_common::HighFreqshiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t val)
 {
-	uint8_t i;
+	const uint32_t clockMask = 1u << clockPin;
+	const uint32_t dataMask = 1u << dataPin;
 
-	for (i = 0; i < 8; i++)
+	for (uint8_t i = 0; i < 8; i++)
 	{
-		gpio_put(dataPin, !!(val & (1 << i)));
-		gpio_put(clockPin, true);
-		busy_wait_us(_HFIN_DELAY);
-		gpio_put(clockPin, false);
-		busy_wait_us(_HFIN_DELAY);
+		gpio_put_masked(clockMask | dataMask, (val & (1 << i)) ? dataMask : 0);
+		_busDelay.wait();
+		sio_hw->gpio_set = clockMask;
+		_busDelay.wait();
+	}
+	sio_hw->gpio_clr = clockMask;
+}
+
+/*!
+	@brief Load the bus engine program, claim a state machine and hand the pins to PIO.
+	@return true success, false no free state machine or instruction memory
+	@note The program is loaded once per PIO block and shared by all instances.
+*/
+bool TM1638plus_common::PIOBegin(void)
+{
+	uint pioIndex = pio_get_index(_pio);
+	_pioSM = pio_claim_unused_sm(_pio, false);
+	if (_pioSM < 0)
+	{
+		return false;
+	}
+	if (_pioProgramOffset[pioIndex] < 0)
+	{
+		if (!pio_can_add_program(_pio, &tm1638plus_program))
+		{
+			pio_sm_unclaim(_pio, _pioSM);
+			_pioSM = -1;
+			return false;
+		}
+		_pioProgramOffset[pioIndex] = (int8_t)pio_add_program(_pio, &tm1638plus_program);
+	}
+	_pioProgramUsers[pioIndex]++;
+
+	// 8 PIO cycles per bit on the bus
+	float clkdiv = (float)clock_get_hz(clk_sys) / (float)(TM_PIO_BUS_HZ * 8);
+	if (clkdiv < 1.0f) clkdiv = 1.0f;
+	tm1638plus_program_init(_pio, _pioSM, _pioProgramOffset[pioIndex],
+		_STROBE_IO, _CLOCK_IO, _DATA_IO, clkdiv);
+	return true;
+}
+
+/*!
+	@brief Wait for the bus engine to finish, release the state machine and program.
+*/
+void TM1638plus_common::PIOClose(void)
+{
+	uint pioIndex = pio_get_index(_pio);
+	PIOWaitIdle();
+	pio_sm_set_enabled(_pio, _pioSM, false);
+	pio_sm_unclaim(_pio, _pioSM);
+	_pioSM = -1;
+	if (_pioProgramUsers[pioIndex] > 0 && --_pioProgramUsers[pioIndex] == 0)
+	{
+		pio_remove_program(_pio, &tm1638plus_program, _pioProgramOffset[pioIndex]);
+		_pioProgramOffset[pioIndex] = -1;
+	}
+	gpio_init(_STROBE_IO);
+	gpio_init(_DATA_IO);
+	gpio_init(_CLOCK_IO);
+	gpio_set_dir(_STROBE_IO, GPIO_OUT);
+	gpio_set_dir(_DATA_IO, GPIO_OUT);
+	gpio_set_dir(_CLOCK_IO, GPIO_OUT);
+}
+
+/*!
+	@brief Block until every queued frame has been clocked out by the state machine.
+*/
+void TM1638plus_common::PIOWaitIdle(void)
+{
+	uint32_t stallMask = 1u << (PIO_FDEBUG_TXSTALL_LSB + _pioSM);
+	while (!pio_sm_is_tx_fifo_empty(_pio, _pioSM))
+	{
+		tight_loop_contents();
+	}
+	// The engine stalls on the frame header pull once the last frame is complete
+	_pio->fdebug = stallMask;
+	while (!(_pio->fdebug & stallMask))
+	{
+		tight_loop_contents();
 	}
 }
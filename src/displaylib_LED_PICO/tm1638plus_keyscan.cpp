@@ -0,0 +1,48 @@
+/*!
+	@file     tm1638plus_keyscan.cpp
+	@author   Gavin Lyons
+	@brief    PICO library source file, background key scanner for TM1638 modules.
+*/
+
+#include "pico/stdlib.h"
+#include "displaylib_LED_PICO/tm1638plus_keyscan.hpp"
+
+/*!
+	@brief Constructor for class TM1638plus_keyscan
+	@param module TM1638 model 1, 2 or 3 object to scan
+*/
+TM1638plus_keyscan::TM1638plus_keyscan(TM1638plus_common &module)
+{
+	_module = &module;
+	_module->_scanHook = deferredScan;
+	_module->_scanHookContext = this;
+}
+
+/*!
+	@brief Destructor for class TM1638plus_keyscan, stops scanning
+*/
+TM1638plus_keyscan::~TM1638plus_keyscan()
+{
+	scanEnd();
+	_module->_scanHook = nullptr;
+	_module->_scanHookContext = nullptr;
+}
+
+/*!
+	@brief Read the key matrix unless a display transfer is in progress
+	@param keys set to one bit per key, 1 = pressed
+	@return true sample taken, false deferred until the bus is free
+*/
+bool TM1638plus_keyscan::readKeys(uint16_t &keys)
+{
+	return _module->scanKeys(keys);
+}
+
+/*!
+	@brief Take the deferred sample, called by the module when the bus is released
+	@param context the scanner
+*/
+void TM1638plus_keyscan::deferredScan(void *context)
+{
+	static_cast<TM1638plus_keyscan *>(context)->scanTick();
+}
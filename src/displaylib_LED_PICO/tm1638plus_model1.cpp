@@ -13,8 +13,9 @@
 	@param strobe  GPIO STB pin
 	@param clock  GPIO CLK pin
 	@param data  GPIO DIO pin
+	@param pio PIO instance for the PIO bus engine, default nullptr = bit-banged GPIO
 */
-TM1638plus_model1::TM1638plus_model1(uint8_t strobe, uint8_t clock, uint8_t data) : TM1638plus_common(strobe, clock, data) {
+TM1638plus_model1::TM1638plus_model1(uint8_t strobe, uint8_t clock, uint8_t data, PIO pio) : TM1638plus_common(strobe, clock, data, pio) {
  // Blank constructor
 }
 
@@ -25,12 +26,7 @@ TM1638plus_model1::TM1638plus_model1(uint8_t strobe, uint8_t clock, uint8_t data
 */
 void TM1638plus_model1::setLED(uint8_t position, uint8_t value)
 {
-	gpio_set_dir(_DATA_IO, GPIO_OUT);
-	sendCommand(TM_WRITE_LOC);
-	gpio_put(_STROBE_IO, false);
-	sendData(TM_LEDS_ADR + (position << 1));
-	sendData(value);
-	gpio_put(_STROBE_IO, true);
+	writeDisplayRAM((TM_LEDS_ADR - TM_SEG_ADR) + (position << 1), value);
 }
 
 /*!
@@ -44,6 +40,8 @@ void TM1638plus_model1::setLED(uint8_t position, uint8_t value)
 void TM1638plus_model1::setLEDs(uint16_t ledvalues)
 {
 	uint8_t colour = 0;
+	bool deferred = _deferredMode;
+	_deferredMode = true;
 	ledvalues = ledvalues & 0x00FF;
 	for (uint8_t LEDposition = 0;  LEDposition < 8; LEDposition++) {
 		if ((ledvalues & (1 << LEDposition)) != 0) {
@@ -52,6 +50,8 @@ void TM1638plus_model1::setLEDs(uint16_t ledvalues)
 		setLED(LEDposition, colour);
 		colour = 0;
 	}
+	_deferredMode = deferred;
+	if (_deferredMode == false) flush();
 }
 
 /*!
@@ -121,17 +121,16 @@ int TM1638plus_model1::displayText(const char *text) {
 		printf("Error: displayText 1: String is a null pointer.\n");
 		return -2;
 	}
-	char c, pos;
-	pos = 0;
-		while ((c = (*text++)) && pos < TM_DISPLAY_SIZE)  {
-		if (*text == '.' && c != '.') {
-			displayASCII(pos++, c, DecPointOn);
-
-			text++;
-		}  else {
-			displayASCII(pos++, c, DecPointOff);
-		}
-		}
+	uint8_t values[TM_DISPLAY_SIZE];
+	uint8_t count = textToDigits(text, values);
+	bool deferred = _deferredMode;
+	_deferredMode = true; // collect all digits, then one flush of the changed ones
+	for (uint8_t pos = 0; pos < count; pos++)
+	{
+		display7Seg(pos, values[pos]);
+	}
+	_deferredMode = deferred;
+	if (_deferredMode == false) flush();
 	return 0;
 }
 
@@ -143,11 +142,7 @@ int TM1638plus_model1::displayText(const char *text) {
 	@note 	0b01000001 in value will set g and a on.
 */
 void TM1638plus_model1::display7Seg(uint8_t position, uint8_t value) { // call 7-segment
-	sendCommand(TM_WRITE_LOC);
-	gpio_put(_STROBE_IO, false);
-	sendData(TM_SEG_ADR + (position << 1));
-	sendData(value);
-	gpio_put(_STROBE_IO, true); 
+	writeDisplayRAM(position << 1, value);
 }
 
 /*!
@@ -157,21 +152,7 @@ void TM1638plus_model1::display7Seg(uint8_t position, uint8_t value) { // call 7
 	@param decimalPoint decimal point or off on the digit.
 */
 void TM1638plus_model1::displayASCII(uint8_t position, uint8_t ascii, DecimalPoint_e decimalPoint) {
-	if (ascii < _ASCII_FONT_OFFSET || ascii >= _ASCII_FONT_END )
-	{
-		printf("Warning : displayASCII : ASCII character is outside font range %u, \n", ascii);
-		ascii = '0';
-	} // check ASCII font bounds
-	const uint8_t *font = SevenSegmentFont::pFontSevenSegptr();
-	switch (decimalPoint)
-	{
-		case DecPointOff: 
-			display7Seg(position, font[ascii - _ASCII_FONT_OFFSET]); 
-			break;
-		case DecPointOn: // add 128 or 0x080 0b1000000 to turn on decimal point/dot in seven seg
-			display7Seg(position, font[ascii- _ASCII_FONT_OFFSET] + DEC_POINT_7_MASK); 
-			break;
-	}
+	display7Seg(position, digitSegments(ascii, decimalPoint));
 }
 
  /*!
@@ -211,21 +192,17 @@ void TM1638plus_model1::displayHex(uint8_t position, uint8_t hex)
 */
 uint8_t TM1638plus_model1::readButtons()
 {
-	uint8_t buttons = 0;
-	uint8_t v =0;
-	
-	gpio_put(_STROBE_IO, false);
-	sendData(TM_BUTTONS_MODE);
-	gpio_set_dir(_DATA_IO, GPIO_IN);
-
-	for (uint8_t i = 0; i < 4; i++)
-	{
-		v = HighFreqshiftin(_DATA_IO, _CLOCK_IO) << i;
-		buttons |= v;
-	}
+	uint8_t keyScan[4];
+	readFrame(keyScan, sizeof(keyScan));
+	return decodeButtons(keyScan);
+}
 
-	gpio_set_dir(_DATA_IO, GPIO_OUT);
-	gpio_put(_STROBE_IO, true); 
-	return buttons;
+/*!
+	@brief Read the key matrix for the key scanner
+	@return buttons 1-8 in bits 0-7, 1 pressed
+*/
+uint16_t TM1638plus_model1::readKeyMatrix(void)
+{
+	return readButtons();
 }
 
@@ -13,8 +13,9 @@
 	@param clock  GPIO CLK pin
 	@param data  GPIO DIO pin
 	@param  swap_nibbles default false, if true, swaps nibbles on display byte.
+	@param pio PIO instance for the PIO bus engine, default nullptr = bit-banged GPIO
 */
-TM1638plus_model2::TM1638plus_model2(uint8_t strobe, uint8_t clock, uint8_t data, bool swap_nibbles) : TM1638plus_common(strobe, clock, data)
+TM1638plus_model2::TM1638plus_model2(uint8_t strobe, uint8_t clock, uint8_t data, bool swap_nibbles, PIO pio) : TM1638plus_common(strobe, clock, data, pio)
 {
 
 	_SWAP_NIBBLES = swap_nibbles;
@@ -38,12 +39,7 @@ void TM1638plus_model2::DisplaySegments(uint8_t segment, uint8_t digit)
 		digit = lower << 4 | upper;
 	}
 
-	segment = (segment << 1);
-	sendCommand(TM_WRITE_LOC);
-	gpio_put(_STROBE_IO, false);
-	sendData(TM_SEG_ADR | segment);
-	sendData(digit);
-	gpio_put(_STROBE_IO, true);
+	writeDisplayRAM(segment << 1, digit);
 }
 
 /*!
@@ -150,43 +146,17 @@ int TM1638plus_model2::DisplayStr(const char *string, uint16_t dots)
 		return -2;
 	}
 
-	const uint8_t *font = SevenSegmentFont::pFontSevenSegptr();
 	uint8_t values[TM_DISPLAY_SIZE];
-	bool done = false;
-	uint8_t Result = 0;
-	memset(values, 0, TM_DISPLAY_SIZE * sizeof(uint8_t));
-
-	for (uint8_t i = 0; i < TM_DISPLAY_SIZE; i++)
-	{
-		if (!done && string[i] != '\0')
-		{
-			if (string[i] < _ASCII_FONT_OFFSET || string[i] >=  _ASCII_FONT_END)
-			{
-				printf("Error: DisplayStr: Character '%c' (ASCII %u) is outside font range.\n", string[i], string[i]);
-				return -4; // Error: Invalid character outside font range
-			}
-			if (dots >> (7 - i) & 1)
-			{ // if dots bit is set for that position apply the mask to turn on dot(0x80).
-				Result = font[string[i] - _ASCII_FONT_OFFSET];
-				values[i] = (Result | DEC_POINT_7_MASK); // apply the Dot bitmask to value extracted from ASCII table
-			}
-			else
-				values[i] = font[string[i] - _ASCII_FONT_OFFSET];
-		}
-		else
-		{
-			done = true;
-			values[i] = (((dots >> (7 - i)) & 1) << 7);
-		}
-	}
+	int result = stringToDigits(string, dots, values);
+	if (result != 0) return result;
 	ASCIItoSegment(values);
 	return 0;
 }
 
 /*!
 	@brief Takes in Array of 8 ASCII bytes , Called from DisplayStr .
-		 Scans each ASCII byte converts to array of 8 segment bytes where each byte represents a segment.
-		 Then calls DisplaySegments() method to display segments on display
+		 Converts the 8 digit bytes to 8 segment bytes where each byte represents a segment,
+		 with a bit matrix transpose, then writes all 8 segments to the display in one burst.
 	@param values An array of 8 ASCII bytes
 	@note
 		byte 0 represents a in segment and then each bit represents the a segment in each digit.
@@ -196,18 +166,21 @@ int TM1638plus_model2::DisplayStr(const char *string, uint16_t dots)
 		The bits are  mapping below abcdefg(dp) = 01234567 ! .
 		See for mapping of seven segment to digit https://en.wikipedia.org/wiki/Seven-segment_display
 		We have to do this as TM1638 model 2 is addressed by segment not digit unlike Model 1&3
+		The digits are packed into a uint64_t in reverse order, so the first digit lands in
+		the MSB of each segment byte, transposed, and nibble swapped if required.
 */
 void TM1638plus_model2::ASCIItoSegment(const uint8_t values[])
 {
+	uint64_t matrix = digitsToSegments(values, _SWAP_NIBBLES);
+
+	bool deferred = _deferredMode;
+	_deferredMode = true;
 	for (uint8_t segment = 0; segment < TM_DISPLAY_SIZE; segment++)
 	{
-		uint8_t SegmentValue = 0;
-		for (uint8_t j = 0; j < TM_DISPLAY_SIZE; j++)
-		{
-			SegmentValue |= ((values[j] >> segment) & 1) << (TM_DISPLAY_SIZE - j - 1);
-		}
-		DisplaySegments(segment, SegmentValue);
+		writeDisplayRAM(segment << 1, (uint8_t)(matrix >> (8 * segment)));
 	}
+	_deferredMode = deferred;
+	if (_deferredMode == false) flush();
 }
 
 /*!
@@ -220,12 +193,9 @@ void TM1638plus_model2::ASCIItoSegment(const uint8_t values[])
 unsigned char TM1638plus_model2::ReadKey16()
 {
 	unsigned char c[4], i, key_value = 0;
-	gpio_put(_STROBE_IO, false);
-	sendData(TM_BUTTONS_MODE);
-	gpio_set_dir(_DATA_IO, GPIO_IN);
+	readFrame(c, sizeof(c));
 	for (i = 0; i < 4; i++)
 	{
-		c[i] = HighFreqshiftin(_DATA_IO, _CLOCK_IO);
 		if (c[i] == 0x04)
 			key_value = 1 + (2 * i); // 00000100 4 0x04
 		if (c[i] == 0x40)
@@ -235,8 +205,6 @@ unsigned char TM1638plus_model2::ReadKey16()
 		if (c[i] == 0x20)
 			key_value = 10 + (2 * i); // 00100000 32 0x20
 	}
-	gpio_set_dir(_DATA_IO, GPIO_OUT);
-	gpio_put(_STROBE_IO, true);
 	return (key_value);
 	// Data matrix for read key_value.
 	// c3 0110 0110  c2 0110 0110  c1 0110 0110  c0 0110 0110 :bytes read
@@ -256,28 +224,16 @@ unsigned char TM1638plus_model2::ReadKey16()
 */
 uint16_t TM1638plus_model2::ReadKey16Two()
 {
+	uint8_t keyScan[4];
+	readFrame(keyScan, sizeof(keyScan));
+	return decodeKeys16(keyScan);
+}
 
-	uint16_t key_value = 0;
-	uint8_t Datain, i = 0;
-	gpio_put(_STROBE_IO, false);
-	sendData(TM_BUTTONS_MODE);
-	gpio_set_dir(_DATA_IO, GPIO_IN);
-	for (i = 0; i < 4; i++)
-	{
-		Datain = HighFreqshiftin(_DATA_IO, _CLOCK_IO);
-		// turn Datain ABCDEFGI = 0BC00FG0  into 00CG00BF see matrix below
-		Datain = (((Datain & 0x40) >> 3 | (Datain & 0x04)) >> 2) | (Datain & 0x20) | (Datain & 0x02) << 3;
-		// i = 0 Datain =  00,10,9,0021 // i = 1 Datain  = 00,12,11,0043
-		// i = 2 Datain =  00 ,14,13,0065 // i = 3 Datain =  00,16,15,0087
-		// key_value =  16,15,14,13,12,11,10,9,8,7,6,5,4,3,2,1.
-		key_value |= ((Datain & 0x000F) << (2 * i)) | (((Datain & 0x00F0) << 4) << (2 * i));
-	}
-	gpio_set_dir(_DATA_IO, GPIO_OUT);
-	gpio_put(_STROBE_IO, true);
-
-	return (key_value);
-
-	//  Data matrix for read key_value. c = datain
-	//   c3 0110 0110  c2 0110 0110  c1 0110 0110  c0 0110 0110 :bytes read
-	//    8,16 7,15     6,14 5,13     4,12 3,11      2,10  1,9 :button value
+/*!
+	@brief Read the key matrix for the key scanner
+	@return buttons S1-S16 in bits 0-15, 1 pressed
+*/
+uint16_t TM1638plus_model2::readKeyMatrix(void)
+{
+	return ReadKey16Two();
 }
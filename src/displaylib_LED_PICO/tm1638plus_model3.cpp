@@ -12,8 +12,9 @@
 	@param strobe  GPIO STB pin
 	@param clock  GPIO CLK pin
 	@param data  GPIO DIO pin
+	@param pio PIO instance for the PIO bus engine, default nullptr = bit-banged GPIO
 */
-TM1638plus_model3::TM1638plus_model3(uint8_t strobe, uint8_t clock, uint8_t data) : TM1638plus_model1(strobe, clock, data) {
+TM1638plus_model3::TM1638plus_model3(uint8_t strobe, uint8_t clock, uint8_t data, PIO pio) : TM1638plus_model1(strobe, clock, data, pio) {
  // Blank constructor
 }
 
@@ -24,12 +25,7 @@ TM1638plus_model3::TM1638plus_model3(uint8_t strobe, uint8_t clock, uint8_t data
 */
 void TM1638plus_model3::setLED(uint8_t position, uint8_t value)
 {
-	gpio_set_dir(_DATA_IO, GPIO_OUT);
-	sendCommand(TM_WRITE_LOC);
-	gpio_put(_STROBE_IO, false);
-	sendData(TM_LEDS_ADR + (position << 1));
-	sendData(value);
-	gpio_put(_STROBE_IO, true);
+	writeDisplayRAM((TM_LEDS_ADR - TM_SEG_ADR) + (position << 1), value);
 }
 
 /*!
@@ -45,6 +41,7 @@ void TM1638plus_model3::setLED(uint8_t position, uint8_t value)
 */
 void TM1638plus_model3::setLEDs(uint16_t ledvalues)
 {
+	LEDFrame_t frame = 0;
 	for (uint8_t LEDposition = 0;  LEDposition < 8; LEDposition++) {
 		uint8_t colour = 0;
 
@@ -55,8 +52,81 @@ void TM1638plus_model3::setLEDs(uint16_t ledvalues)
 			colour |= TM_GREEN_LED; //scan upper byte, set green if one
 		}
 
-		setLED(LEDposition, colour);
+		frame |= (colour << (2 * LEDposition));
 	}
+	setLEDFrame(frame);
+}
+
+/*!
+	@brief Set all eight bi-color LEDs from a packed frame
+	@param frame 2 bits per LED holding a TMLEDColors value, L1 in bits 1-0 to L8 in bits 15-14
+	@note Updates the shadow display RAM, the LEDs go out with any pending
+		segment data in one burst on flush(), at once unless deferred mode is on.
+*/
+void TM1638plus_model3::setLEDFrame(LEDFrame_t frame)
+{
+	bool deferred = _deferredMode;
+	_deferredMode = true;
+	for (uint8_t LEDposition = 0; LEDposition < 8; LEDposition++)
+	{
+		setLED(LEDposition, (frame >> (2 * LEDposition)) & 0x03);
+	}
+	_deferredMode = deferred;
+	if (_deferredMode == false) flush();
+}
+
+/*!
+	@brief Get the bi-color LED frame held in the shadow display RAM
+	@return 2 bits per LED holding a TMLEDColors value, L1 in bits 1-0 to L8 in bits 15-14
+*/
+TM1638plus_model3::LEDFrame_t TM1638plus_model3::getLEDFrame(void) const
+{
+	LEDFrame_t frame = 0;
+	for (uint8_t LEDposition = 0; LEDposition < 8; LEDposition++)
+	{
+		frame |= (_displayRAM[(TM_LEDS_ADR - TM_SEG_ADR) + (LEDposition << 1)] & 0x03) << (2 * LEDposition);
+	}
+	return frame;
+}
+
+/*!
+	@brief Set all eight bi-color LEDs to one colour
+	@param colour TM_RED_LED , TM_GREEN_LED or TM_OFF_LED
+*/
+void TM1638plus_model3::fillLEDs(TMLEDColors colour)
+{
+	setLEDFrame((colour & 0x03) * 0x5555);
+}
+
+/*!
+	@brief Set a range of bi-color LEDs to one colour, other LEDs unchanged
+	@param start first LED 0-7 == L1-L8 on PCB
+	@param count number of LEDs, range is clipped at L8
+	@param colour TM_RED_LED , TM_GREEN_LED or TM_OFF_LED
+*/
+void TM1638plus_model3::setLEDRange(uint8_t start, uint8_t count, TMLEDColors colour)
+{
+	if (start >= 8 || count == 0) return;
+	if (count > 8 - start) count = 8 - start;
+	LEDFrame_t mask = (LEDFrame_t)(((1UL << (2 * count)) - 1) << (2 * start));
+	LEDFrame_t frame = getLEDFrame();
+	frame = (frame & ~mask) | (((colour & 0x03) * 0x5555) & mask);
+	setLEDFrame(frame);
+}
+
+/*!
+	@brief Rotate the bi-color LED pattern
+	@param steps positions to rotate, positive towards L8 , negative towards L1
+*/
+void TM1638plus_model3::rotateLEDs(int8_t steps)
+{
+	uint8_t shift = (uint8_t)(2 * (steps & 0x07)); // positive remainder, -1 == 7
+	LEDFrame_t frame = getLEDFrame();
+	if (shift != 0)
+	{
+		frame = (LEDFrame_t)((frame << shift) | (frame >> (16 - shift)));
+	}
+	setLEDFrame(frame);
 }
 
 